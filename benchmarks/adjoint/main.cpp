@@ -0,0 +1,156 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <qode1_model.hpp>
+#include <sensitivity.hpp>
+#include <adjoint.hpp>
+#include <checkpoint.hpp>
+#include <rkgl.hpp>
+#include <bench.hpp>
+
+// Cost of the gradient of a terminal loss relative to one forward solve:
+//  * qode1: chain of coupled Lotka-Volterra pairs with one growth rate per
+//    pair, adjoint with binomial checkpointing versus forward
+//    sensitivities;
+//  * rkgl<double, 3>: the same chain as a plain right-hand side with a
+//    hand-written vector-Jacobian product.
+
+constexpr size_t pairs = 16;
+constexpr size_t chain_dim = 2 * pairs;
+constexpr size_t steps = 1000;
+constexpr double h = 0.01;
+
+std::shared_ptr<qode::qode1_model<double>> chain_model()
+{
+  auto model = std::make_shared<qode::qode1_model<double>>(chain_dim, pairs);
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    model->b_param(i, i, p);
+    model->b_coef(i + 1, i + 1, -1.0);
+    model->c_coef(i, i, i + 1, -4.0 / 3.0);
+    model->c_coef(i + 1, i, i + 1, 1.0);
+    model->b_coef(i, (i + 2) % chain_dim, 0.01);
+  }
+  return model;
+}
+
+void chain_f(const double *x, double *y)
+{
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    y[i] = 2.0 / 3.0 * x[i] - 4.0 / 3.0 * x[i] * x[i + 1] + 0.01 * x[(i + 2) % chain_dim];
+    y[i + 1] = x[i] * x[i + 1] - x[i + 1];
+  }
+}
+
+void chain_vjp(const double *x, const double *w, double *out)
+{
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    out[i] = (2.0 / 3.0 - 4.0 / 3.0 * x[i + 1]) * w[i] + x[i + 1] * w[i + 1];
+    out[i + 1] = -4.0 / 3.0 * x[i] * w[i] + (x[i] - 1.0) * w[i + 1];
+  }
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    out[(i + 2) % chain_dim] += 0.01 * w[i];
+  }
+}
+
+int main()
+{
+  auto model = chain_model();
+  const std::vector<double> theta(pairs, 2.0 / 3.0);
+
+  std::cout << "qode1, n = " << chain_dim << ", P = " << pairs << ", N = " << steps << "\n";
+
+  qode::qode1_instance<double> run(model);
+  const bench::result r_fwd = bench::measure("forward solve", 1, [&]()
+                                             {
+                                               run.theta = theta;
+                                               run.x.assign(chain_dim, 1.0);
+                                               for (size_t i = 0; i < steps; ++i)
+                                                 run.step(h);
+                                               bench::do_not_optimize(run.x[0]); });
+
+  qode::qode1_sensitivity<double> sens(model);
+  const bench::result r_sens = bench::measure("forward sensitivities", 1, [&]()
+                                              {
+                                                sens.theta = theta;
+                                                sens.x.assign(chain_dim, 1.0);
+                                                sens.reset_sensitivities();
+                                                for (size_t i = 0; i < steps; ++i)
+                                                  sens.step(h);
+                                                bench::do_not_optimize(sens.S[0]); });
+
+  qode::qode1_adjoint<double> adj(model);
+  const bench::result r_adj = bench::measure("adjoint + checkpointing", 1, [&]()
+                                             {
+                                               adj.theta = theta;
+                                               adj.x.assign(chain_dim, 1.0);
+                                               adj.gradient(steps, h, [](size_t i, const double *, double *lambda)
+                                                            {
+                                                              if (i == steps)
+                                                                lambda[0] += 1.0; });
+                                               bench::do_not_optimize(adj.grad[0]); });
+
+  bench::print(r_fwd);
+  bench::print(r_sens);
+  bench::print(r_adj);
+  std::cout << "  gradient / forward: sensitivities " << r_sens.seconds / r_fwd.seconds
+            << ", adjoint " << r_adj.seconds / r_fwd.seconds << "\n";
+  std::cout << "  adjoint: " << adj.checkpoint.peak_states << " stored states, "
+            << adj.checkpoint.forward_steps << " forward steps\n";
+
+  std::cout << "\nrkgl<double, 3>, n = " << chain_dim << ", N = " << steps << "\n";
+
+  rkgl::rkgl<double, 3> core;
+  core.set(chain_dim);
+  rkgl::mini_jacobian<double> mj;
+  mj.set(chain_dim);
+  auto f = [](const double *x, double *y)
+  { chain_f(x, y); };
+  auto vjp = [](const double *x, const double *w, double *out)
+  { chain_vjp(x, w, out); };
+
+  auto forward = [&](std::vector<double> &x, size_t)
+  {
+    mj.evaluate(f, x.data(), h);
+    core.step(f, mj, x.data(), h, 1e-13);
+  };
+
+  std::vector<double> x_rk;
+  const bench::result r_rk = bench::measure("forward solve", 1, [&]()
+                                            {
+                                              x_rk.assign(chain_dim, 1.0);
+                                              for (size_t i = 0; i < steps; ++i)
+                                                forward(x_rk, i);
+                                              bench::do_not_optimize(x_rk[0]); });
+
+  std::vector<double> lambda(chain_dim);
+  math::checkpoint_stats stats;
+  const bench::result r_rk_adj = bench::measure("adjoint + checkpointing", 1, [&]()
+                                                {
+                                                  std::fill(lambda.begin(), lambda.end(), 0.0);
+                                                  lambda[0] = 1.0;
+                                                  stats = math::binomial_reverse(steps, math::bisection_snapshots(steps), std::vector<double>(chain_dim, 1.0), forward,
+                                                                                  [&](const std::vector<double> &x_i, size_t i)
+                                                                                  {
+                                                                                    std::vector<double> x = x_i;
+                                                                                    forward(x, i);
+                                                                                    core.adjoint_step(vjp, x_i.data(), h, lambda.data(), 1e-13);
+                                                                                  });
+                                                  bench::do_not_optimize(lambda[0]); });
+
+  bench::print(r_rk);
+  bench::print(r_rk_adj);
+  std::cout << "  gradient / forward: adjoint " << r_rk_adj.seconds / r_rk.seconds << "\n";
+  std::cout << "  adjoint: " << stats.peak_states << " stored states, "
+            << stats.forward_steps << " forward steps\n";
+
+  return 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <qode1.hpp>
+#include <kernel_config.hpp>
+#include <bench.hpp>
+
+// One-shot autotuning of the dense solve kernels of the qode1 step.
+//
+//     ode_lab_autotune [FILE]          (default ode_lab_kernels.cfg)
+//
+// For float, double and long double it times, per n, the fixed-size
+// kernels against lu_naive (n <= 16) and lu_blocked with several block
+// sizes against lu_naive (n >= 16), and writes the crossover points as a
+// kernel configuration (see kernel_config.hpp). Use it with
+//
+//     ODE_LAB_KERNEL_CONFIG=ode_lab_kernels.cfg ./my_solver
+
+template <class U>
+double time_kernel(const size_t n, qode::symmetric_kernel<U> kernel)
+{
+  std::vector<U> mat0(n * n), mat(n * n), vec(n), x(n);
+  for (size_t i = 0; i < n * n; ++i)
+    mat0[i] = U(0.1) * U(std::sin(0.7 * double(i)));
+  for (size_t i = 0; i < n; ++i)
+  {
+    mat0[n * i + i] -= U(2);
+    vec[i] = U(1);
+  }
+
+  const size_t iterations = std::max<size_t>(1, size_t(4e6 / double(n * n * n + 64)));
+  const bench::result r = bench::measure("", iterations, [&]
+                                         {
+                                           std::copy(mat0.begin(), mat0.end(), mat.begin());
+                                           std::fill(x.begin(), x.end(), U(1));
+                                           kernel(n, U(0.1), mat.data(), vec.data(), x.data());
+                                           bench::do_not_optimize(x[0]); }, 5);
+  return r.ns_per_iteration();
+}
+
+template <class U>
+void blocked_with(const size_t n, const U h, U mat[], const U vec[], U x[])
+{
+  qode::symmetric_solve_blocked<U>(n, h, mat, vec, x);
+}
+
+template <class U>
+math::kernel_thresholds tune()
+{
+  const char *name = math::kernel_scalar_name<U>();
+  math::kernel_thresholds t;
+
+  // fixed-size kernels: used up to the first n where lu_naive is clearly
+  // faster (5 % margin against timing noise at the smallest sizes)
+  const auto fixed = qode::kernel_detail::fixed_kernels<U>(std::make_index_sequence<math::max_fixed_kernel>{});
+  t.fixed_max = 0;
+  std::cout << name << "\n  n    fixed ns    naive ns\n";
+  for (size_t n = 1; n <= math::max_fixed_kernel; ++n)
+  {
+    const double t_fixed = time_kernel<U>(n, fixed[n - 1]);
+    const double t_naive = time_kernel<U>(n, &qode::symmetric_update<U>);
+    std::cout << std::setw(3) << n << std::fixed << std::setprecision(1) << std::setw(12) << t_fixed
+              << std::setw(12) << t_naive << "\n";
+    if (t.fixed_max == n - 1 && t_fixed <= 1.05 * t_naive)
+      t.fixed_max = n;
+  }
+
+  // lu_blocked: block size at the largest n, then the smallest n from which
+  // it wins at every larger size
+  const std::vector<size_t> sizes = {16, 24, 32, 48, 64, 96, 128, 192, 256};
+  std::vector<double> t_naive(sizes.size()), t_blocked(sizes.size());
+
+  double best = std::numeric_limits<double>::infinity();
+  for (const size_t block : {16, 32, 64})
+  {
+    std::istringstream cfg(std::string(name) + " " + std::to_string(t.fixed_max) + " 1 " + std::to_string(block));
+    math::load_kernel_config(cfg);
+    const double time = time_kernel<U>(sizes.back(), &blocked_with<U>);
+    if (time < best)
+    {
+      best = time;
+      t.block = block;
+    }
+  }
+  std::istringstream cfg(std::string(name) + " " + std::to_string(t.fixed_max) + " 1 " + std::to_string(t.block));
+  math::load_kernel_config(cfg);
+
+  std::cout << "  n    naive ns  blocked ns  (block " << t.block << ")\n";
+  t.blocked_min = std::numeric_limits<int>::max();
+  for (size_t s = 0; s < sizes.size(); ++s)
+  {
+    t_naive[s] = time_kernel<U>(sizes[s], &qode::symmetric_update<U>);
+    t_blocked[s] = time_kernel<U>(sizes[s], &blocked_with<U>);
+    std::cout << std::setw(3) << sizes[s] << std::fixed << std::setprecision(1) << std::setw(12) << t_naive[s]
+              << std::setw(12) << t_blocked[s] << "\n";
+  }
+  for (size_t s = sizes.size(); s-- > 0 && t_blocked[s] < t_naive[s];)
+    t.blocked_min = sizes[s];
+  t.blocked_min = std::max(t.blocked_min, t.fixed_max + 1);
+
+  std::cout << std::defaultfloat << "  -> fixed_max " << t.fixed_max << ", blocked_min " << t.blocked_min
+            << ", block " << t.block << "\n\n";
+  return t;
+}
+
+int main(int argc, char **argv)
+{
+  const std::string path = argc > 1 ? argv[1] : "ode_lab_kernels.cfg";
+
+  const math::kernel_thresholds t_float = tune<float>();
+  const math::kernel_thresholds t_double = tune<double>();
+  const math::kernel_thresholds t_long = tune<long double>();
+
+  std::ofstream out(path);
+  out << "# ode_lab kernel thresholds, written by ode_lab_autotune for this host\n"
+      << "# type fixed_max blocked_min block\n";
+  math::write_kernel_config<float>(out, t_float);
+  math::write_kernel_config<double>(out, t_double);
+  math::write_kernel_config<long double>(out, t_long);
+  if (!out)
+  {
+    std::cerr << "cannot write " << path << "\n";
+    return 1;
+  }
+
+  std::cout << "written to " << path << "\n";
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include <qode1.hpp>
+#include <composition.hpp>
+#include <rkgl.hpp>
+#include <bench.hpp>
+
+// Work-precision comparison on Lotka-Volterra over t in [0, 20]: plain
+// qode1_core::step_adaptive versus symmetric compositions of order 4, 6, 8
+// in adaptive mode. The reference solution comes from rkgl<double, 8>.
+
+class Lotka_Voltera : public qode::qode1_core<double>
+{
+public:
+  Lotka_Voltera() : qode::qode1_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+constexpr double t_end = 20.0;
+
+void report(const std::string &name, const double mu, const double *ref, auto &&run)
+{
+  Lotka_Voltera core;
+  const bench::result r = bench::measure(name, 10, [&]()
+                                         {
+                                           core.x = {1.0, 1.0};
+                                           run(core);
+                                           bench::do_not_optimize(core.x[0]); });
+  const double err = std::hypot(core.x[0] - ref[0], core.x[1] - ref[1]);
+
+  std::cout << std::left << std::setw(30) << name << std::right << std::setw(8) << mu
+            << std::scientific << std::setprecision(3)
+            << std::setw(14) << err << std::setw(14) << 1e-9 * r.ns_per_iteration() << "\n"
+            << std::defaultfloat;
+}
+
+int main()
+{
+  auto f = [](const double *x, double *y)
+  {
+    y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+    y[1] = x[0] * x[1] - x[1];
+  };
+
+  double ref[2] = {1.0, 1.0};
+  {
+    rkgl::rkgl<double, 8> core;
+    core.set(2);
+    rkgl::mini_jacobian<double> mj;
+    mj.set(2);
+    for (int i = 0; i < 2000; ++i)
+    {
+      mj.evaluate(f, ref, 0.01);
+      core.step(f, mj, ref, 0.01, 1e-15);
+    }
+  }
+
+  std::cout << "method                              mu         error      time [s]\n";
+
+  for (double mu : {0.1, 0.03, 0.01, 0.003, 0.001})
+    report("qode1 step_adaptive", mu, ref, [mu](Lotka_Voltera &core)
+           {
+             double h = core.suggest_first_stepsize(1.0, mu);
+             double t = 0.0;
+             while (t + h < t_end)
+             {
+               core.step_adaptive(h, mu);
+               t += h;
+             }
+             core.step(t_end - t); });
+
+  const qode::composition<double> c4(4, qode::composition_scheme::suzuki_fractal);
+  const qode::composition<double> c6(6, qode::composition_scheme::yoshida_optimal);
+  const qode::composition<double> c8(8, qode::composition_scheme::yoshida_optimal);
+
+  for (auto [name, c] : {std::pair{"composition order 4 (5 st.)", &c4},
+                         std::pair{"composition order 6 (7 st.)", &c6},
+                         std::pair{"composition order 8 (15 st.)", &c8}})
+    for (double mu : {0.3, 0.1, 0.03, 0.01})
+      report(name, mu, ref, [mu, c](Lotka_Voltera &core)
+             {
+               double h = c->suggest_first_stepsize(core, 1.0, mu);
+               double t = 0.0;
+               while (t + h < t_end)
+               {
+                 c->step_adaptive(core, h, mu);
+                 t += h;
+               }
+               c->step(core, t_end - t); });
+
+  return 0;
+}
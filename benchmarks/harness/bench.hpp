@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// =============================================================================
+//  FILE: bench.hpp  -  minimal timing harness shared by the benchmarks
+// =============================================================================
+//
+//  bench::measure(name, iterations, body) runs body() `iterations` times,
+//  repeats the whole loop several times and keeps the fastest repetition.
+//  bench::do_not_optimize(value) keeps results of the measured code alive so
+//  that the compiler cannot remove it.
+//
+// =============================================================================
+
+namespace bench
+{
+  template <class T>
+  inline void do_not_optimize(T const &value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+  }
+
+  struct result
+  {
+    std::string name;
+    size_t iterations = 0;
+    double seconds = 0.0;
+
+    double ns_per_iteration() const
+    {
+      return 1e9 * seconds / double(iterations);
+    }
+  };
+
+  template <class F>
+  inline result measure(const std::string_view &name, const size_t iterations, F &&body, const int repeats = 5)
+  {
+    using clock = std::chrono::steady_clock;
+
+    result r{std::string(name), iterations, 0.0};
+
+    for (int rep = 0; rep < repeats; ++rep)
+    {
+      const auto start = clock::now();
+      for (size_t i = 0; i < iterations; ++i)
+        body();
+      const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+      r.seconds = rep == 0 ? elapsed : std::min(r.seconds, elapsed);
+    }
+
+    return r;
+  }
+
+  inline void print(const result &r)
+  {
+    std::cout << std::left << std::setw(40) << r.name
+              << std::right << std::setw(14) << std::fixed << std::setprecision(2) << r.ns_per_iteration() << " ns/iter"
+              << std::setw(12) << r.iterations << " iter\n";
+  }
+
+  inline void print_speedup(const result &reference, const result &r)
+  {
+    std::cout << "  " << r.name << " vs " << reference.name << ": "
+              << std::fixed << std::setprecision(2) << reference.ns_per_iteration() / r.ns_per_iteration() << "x\n";
+  }
+}
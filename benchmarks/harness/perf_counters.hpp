@@ -0,0 +1,297 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <iomanip>
+#include <bench.hpp>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// =============================================================================
+//  FILE: perf_counters.hpp  -  hardware performance counters for benchmarks
+// =============================================================================
+//
+//  bench::perf_counters opens the hardware events
+//
+//      cycles, instructions, L1d read misses, LLC read misses, branch misses
+//
+//  of the calling thread with perf_event_open (Linux only) and counts them
+//  between start() and stop(). Every event is opened on its own, so an event
+//  the PMU or the hypervisor does not provide is simply missing; when none
+//  can be opened (no Linux, perf_event_paranoid too high, seccomp in a
+//  container) available() is false and reason() says why. Counts are scaled
+//  by time_enabled / time_running when the kernel multiplexes them.
+//
+//  bench::measure_counted(name, iterations, body, flops) is bench::measure
+//  plus one extra counted run of the loop; print(counted_result) reports the
+//  time, IPC and GFLOP/s (from the caller's flop count per iteration) and
+//  the misses per iteration, or "counters unavailable".
+//
+// =============================================================================
+
+namespace bench
+{
+  enum class event : size_t
+  {
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    branch_misses,
+    count_
+  };
+
+  inline constexpr size_t event_count = size_t(event::count_);
+
+  struct counter_values
+  {
+    std::array<double, event_count> value{};
+    std::array<bool, event_count> valid{};
+
+    bool has(const event e) const { return valid[size_t(e)]; }
+    double operator[](const event e) const { return value[size_t(e)]; }
+  };
+
+  class perf_counters
+  {
+  public:
+    perf_counters();
+    ~perf_counters();
+
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+
+    bool available() const;
+    const std::string &reason() const;
+
+    void start();
+    counter_values stop();
+
+  private:
+    std::array<int, event_count> fd;
+    std::string why;
+  };
+
+  // -------------------------------------------------------------------------
+  //  perf_counters implementation
+  // -------------------------------------------------------------------------
+
+#if defined(__linux__)
+
+  namespace perf_detail
+  {
+    inline int open_event(const uint32_t type, const uint64_t config)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    inline uint64_t cache_event(const uint64_t cache, const uint64_t op, const uint64_t result)
+    {
+      return cache | (op << 8) | (result << 16);
+    }
+  }
+
+  inline perf_counters::perf_counters()
+  {
+    using perf_detail::cache_event;
+
+    const std::array<std::pair<uint32_t, uint64_t>, event_count> events = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+    int first_error = 0;
+    for (size_t i = 0; i < event_count; i++)
+    {
+      fd[i] = perf_detail::open_event(events[i].first, events[i].second);
+      if (fd[i] < 0 && first_error == 0)
+        first_error = errno;
+    }
+
+    if (!available())
+    {
+      why = "perf_event_open: " + std::string(std::strerror(first_error));
+      if (first_error == EACCES || first_error == EPERM)
+        why += " (see /proc/sys/kernel/perf_event_paranoid)";
+      else if (first_error == ENOENT || first_error == ENODEV || first_error == EOPNOTSUPP)
+        why += " (no hardware PMU exposed, e.g. in a VM or container)";
+    }
+  }
+
+  inline perf_counters::~perf_counters()
+  {
+    for (const int f : fd)
+      if (f >= 0)
+        close(f);
+  }
+
+  inline bool perf_counters::available() const
+  {
+    for (const int f : fd)
+      if (f >= 0)
+        return true;
+    return false;
+  }
+
+  inline void perf_counters::start()
+  {
+    for (const int f : fd)
+      if (f >= 0)
+      {
+        ioctl(f, PERF_EVENT_IOC_RESET, 0);
+        ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+      }
+  }
+
+  inline counter_values perf_counters::stop()
+  {
+    counter_values c;
+    for (size_t i = 0; i < event_count; i++)
+    {
+      if (fd[i] < 0)
+        continue;
+      ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+
+      // value, time_enabled, time_running
+      uint64_t data[3];
+      if (read(fd[i], data, sizeof(data)) != ssize_t(sizeof(data)) || data[2] == 0)
+        continue;
+      c.value[i] = double(data[0]) * double(data[1]) / double(data[2]);
+      c.valid[i] = true;
+    }
+    return c;
+  }
+
+#else
+
+  inline perf_counters::perf_counters() : why("hardware counters need Linux perf_event_open")
+  {
+    fd.fill(-1);
+  }
+
+  inline perf_counters::~perf_counters() {}
+
+  inline bool perf_counters::available() const
+  {
+    return false;
+  }
+
+  inline void perf_counters::start() {}
+
+  inline counter_values perf_counters::stop()
+  {
+    return {};
+  }
+
+#endif
+
+  inline const std::string &perf_counters::reason() const
+  {
+    return why;
+  }
+
+  // -------------------------------------------------------------------------
+  //  counted measurements
+  // -------------------------------------------------------------------------
+
+  struct counted_result
+  {
+    result timing;
+    counter_values counts; // per iteration
+    double flops = 0.0;    // per iteration, as given by the caller
+    std::string unavailable;
+
+    double ipc() const
+    {
+      return counts.has(event::cycles) && counts.has(event::instructions) && counts[event::cycles] > 0.0
+                 ? counts[event::instructions] / counts[event::cycles]
+                 : 0.0;
+    }
+
+    double gflops() const
+    {
+      return flops / timing.ns_per_iteration();
+    }
+  };
+
+  inline perf_counters &thread_counters()
+  {
+    thread_local perf_counters counters;
+    return counters;
+  }
+
+  template <class F>
+  inline counted_result measure_counted(const std::string_view &name, const size_t iterations, F &&body,
+                                        const double flops_per_iteration = 0.0, const int repeats = 5)
+  {
+    counted_result r;
+    r.timing = measure(name, iterations, body, repeats);
+    r.flops = flops_per_iteration;
+
+    perf_counters &counters = thread_counters();
+    if (!counters.available())
+    {
+      r.unavailable = counters.reason();
+      return r;
+    }
+
+    counters.start();
+    for (size_t i = 0; i < iterations; ++i)
+      body();
+    r.counts = counters.stop();
+    for (double &v : r.counts.value)
+      v /= double(iterations);
+    return r;
+  }
+
+  inline void print(const counted_result &r)
+  {
+    std::cout << std::left << std::setw(40) << r.timing.name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(2) << r.timing.ns_per_iteration() << " ns";
+    if (r.flops > 0.0)
+      std::cout << std::setw(8) << std::setprecision(2) << r.gflops() << " GFLOP/s";
+
+    if (!r.unavailable.empty())
+    {
+      std::cout << "   counters unavailable\n";
+      return;
+    }
+
+    if (r.ipc() > 0.0)
+      std::cout << std::setw(7) << std::setprecision(2) << r.ipc() << " IPC";
+    const std::pair<event, const char *> misses[] = {{event::l1d_misses, " L1d"}, {event::llc_misses, " LLC"}, {event::branch_misses, " br"}};
+    for (const auto &[e, label] : misses)
+    {
+      std::cout << std::setw(10) << std::setprecision(1);
+      if (r.counts.has(e))
+        std::cout << r.counts[e];
+      else
+        std::cout << "-";
+      std::cout << label;
+    }
+    std::cout << " misses/iter\n"
+              << std::defaultfloat;
+  }
+}
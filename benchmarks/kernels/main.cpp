@@ -0,0 +1,93 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <ling.hpp>
+#include <bench.hpp>
+#include <perf_counters.hpp>
+
+// Time, GFLOP/s, IPC and cache / branch misses of the linear algebra
+// kernels in ling.hpp. The counters come from bench::perf_counters and are
+// reported as unavailable where perf_event_open is not permitted (e.g. in
+// containers with perf_event_paranoid > 1).
+//
+// Flop counts: dot_product 2n, fb_naive 2n^2, lu 2n^3/3, solve_opt<n>
+// 2n^3/3 + 2n^2. The factorisations include copying the matrix back into
+// place (n^2 loads and stores, no flops) before every call.
+
+std::vector<double> diagonally_dominant(const size_t n)
+{
+  std::vector<double> A(n * n);
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = 0.1 * std::sin(0.7 * double(i));
+  for (size_t i = 0; i < n; ++i)
+    A[n * i + i] += 1.0;
+  return A;
+}
+
+void dot(const size_t n)
+{
+  std::vector<double> a(n, 1.0), b(n, 0.5);
+  const size_t iterations = 100000000 / n + 1;
+  bench::print(bench::measure_counted("dot_product, n " + std::to_string(n), iterations, [&]()
+                                      { bench::do_not_optimize(math::dot_product(n, a.data(), b.data())); }, 2.0 * double(n)));
+}
+
+template <class Factor>
+void lu(const std::string &name, const size_t n, Factor &&factor)
+{
+  const std::vector<double> A0 = diagonally_dominant(n);
+  std::vector<double> A(n * n);
+  const size_t iterations = 200000000 / (n * n * n) + 1;
+  bench::print(bench::measure_counted(name + ", n " + std::to_string(n), iterations, [&]()
+                                      {
+                                        std::copy(A0.begin(), A0.end(), A.begin());
+                                        factor(n, A.data());
+                                        bench::do_not_optimize(A[0]); }, 2.0 * double(n * n * n) / 3.0));
+}
+
+void substitution(const size_t n)
+{
+  std::vector<double> A = diagonally_dominant(n), v(n, 1.0);
+  math::lu_naive(n, A.data());
+  const size_t iterations = 100000000 / (n * n) + 1;
+  bench::print(bench::measure_counted("fb_naive, n " + std::to_string(n), iterations, [&]()
+                                      { math::fb_naive(n, A.data(), v.data()); bench::do_not_optimize(v[0]); }, 2.0 * double(n * n)));
+}
+
+template <size_t n>
+void solve_opt()
+{
+  const std::vector<double> A0 = diagonally_dominant(n);
+  double A[n * n], b[n];
+  bench::print(bench::measure_counted("solve_opt<" + std::to_string(n) + ">", 2000000, [&]()
+                                      {
+                                        std::copy(A0.begin(), A0.end(), A);
+                                        std::fill(b, b + n, 1.0);
+                                        math::solve_opt<n>(A, b);
+                                        bench::do_not_optimize(b[0]); }, 2.0 * double(n * n * n) / 3.0 + 2.0 * double(n * n)));
+}
+
+int main()
+{
+  bench::perf_counters &counters = bench::thread_counters();
+  if (!counters.available())
+    std::cout << "hardware counters unavailable: " << counters.reason() << "\n\n";
+
+  for (const size_t n : {64, 4096, 1 << 20})
+    dot(n);
+  for (const size_t n : {16, 128, 512})
+  {
+    lu("lu_naive", n, [](size_t m, double *A)
+       { math::lu_naive(m, A); });
+    lu("lu_blocked", n, [](size_t m, double *A)
+       { math::lu_blocked(m, A); });
+  }
+  for (const size_t n : {16, 512})
+    substitution(n);
+  solve_opt<2>();
+  solve_opt<4>();
+  solve_opt<6>();
+
+  return 0;
+}
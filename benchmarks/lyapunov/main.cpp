@@ -0,0 +1,92 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <qode1.hpp>
+#include <lyapunov.hpp>
+#include <bench.hpp>
+
+// Lyapunov spectrum of the Lorenz system: tangent vectors propagated with
+// the LU factors of the qode1 step (qode1_lyapunov) versus the previous
+// approach of integrating one perturbed trajectory per direction. For n = 3
+// the factorisation is cheap; the gain grows with the dimension as every
+// extra trajectory costs a full O(n^3) step and a tangent only O(n^2).
+
+template <class Base, class... Args>
+class Lorenz : public Base
+{
+public:
+  explicit Lorenz(Args... args) : Base(args...) {};
+
+  void set_coef() override
+  {
+    this->b_coef(0, 0) = -10.0;
+    this->b_coef(0, 1) = 10.0;
+
+    this->b_coef(1, 0) = 28.0;
+    this->b_coef(1, 1) = -1.0;
+    this->c_coef(1, 0, 2) = -1.0;
+
+    this->b_coef(2, 2) = -8.0 / 3.0;
+    this->c_coef(2, 0, 1) = 1.0;
+  }
+};
+
+using Lorenz_core = Lorenz<qode::qode1_core<double>, size_t>;
+using Lorenz_lyapunov = Lorenz<qode::qode1_lyapunov<double>, size_t, int>;
+
+int main()
+{
+  const double h = 0.01;
+  const size_t steps = 10000;
+
+  Lorenz_core plain(3);
+  plain.x = {1.0, 1.0, 1.0};
+  const bench::result r_plain = bench::measure("qode1_core state only", steps, [&]()
+                                               {
+                                                 plain.step(h);
+                                                 bench::do_not_optimize(plain.x[0]); });
+
+  Lorenz_lyapunov lyap(3, 3);
+  lyap.x = {1.0, 1.0, 1.0};
+  lyap.reset_tangents();
+  const bench::result r_lyap = bench::measure("qode1_lyapunov, 3 tangents", steps, [&]()
+                                              {
+                                                lyap.step(h);
+                                                bench::do_not_optimize(lyap.x[0]); });
+
+  // reference state plus one trajectory displaced by eps along each axis,
+  // pulled back towards the reference every step (cost comparison only)
+  const double eps = 1e-8;
+  std::vector<Lorenz_core> runs(4, Lorenz_core(3));
+  for (size_t k = 0; k < runs.size(); ++k)
+  {
+    runs[k].x = {1.0, 1.0, 1.0};
+    if (k > 0)
+      runs[k].x[k - 1] += eps;
+  }
+  const bench::result r_fd = bench::measure("4 trajectories (finite differences)", steps, [&]()
+                                            {
+                                              for (auto &r : runs)
+                                                r.step(h);
+                                              for (size_t k = 1; k < runs.size(); ++k)
+                                                for (size_t i = 0; i < 3; ++i)
+                                                {
+                                                  const double d = runs[k].x[i] - runs[0].x[i];
+                                                  runs[k].x[i] = runs[0].x[i] + d * eps / std::max(std::abs(d), eps);
+                                                }
+                                              bench::do_not_optimize(runs[0].x[0]); });
+
+  bench::print(r_plain);
+  bench::print(r_lyap);
+  bench::print(r_fd);
+  bench::print_speedup(r_fd, r_lyap);
+
+  lyap.synchronize();
+  const std::vector<double> lambda = lyap.exponents();
+  std::cout << "exponents:";
+  for (const double l : lambda)
+    std::cout << " " << l;
+  std::cout << "\n";
+
+  return 0;
+}
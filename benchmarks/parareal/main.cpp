@@ -0,0 +1,115 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <parareal.hpp>
+#include <qode1.hpp>
+#include <rkgl.hpp>
+#include <bench.hpp>
+
+// One long Lotka-Volterra trajectory, t in [0, 100], split into time
+// slices. Fine propagator: rkgl<double, 4> (order 8), h = 0.02. Coarse
+// propagator: qode1_core with fixed steps h_coarse. Parareal over a
+// thread pool is compared with the serial fine integration in wall-clock
+// time and end-state deviation. The bound is the speedup for `threads`
+// free cores from the counted fine slice solves (coarse sweeps neglected);
+// the measured speedup reaches it only with that many hardware threads.
+
+auto lotka_volterra = [](const double *x, double *y)
+{
+  y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+  y[1] = x[0] * x[1] - x[1];
+};
+
+class Lotka_Voltera : public qode::qode1_core<double>
+{
+public:
+  Lotka_Voltera() : qode::qode1_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+constexpr double t_end = 100.0;
+constexpr double h_fine = 0.02;
+
+void fine_integrate(double *x, const double span)
+{
+  rkgl::rkgl<double, 4> core;
+  core.set(2);
+  rkgl::mini_jacobian<double> mj;
+  mj.set(2);
+
+  const int steps = int(std::ceil(span / h_fine - 1e-9));
+  const double h = span / steps;
+  for (int i = 0; i < steps; ++i)
+  {
+    mj.evaluate(lotka_volterra, x, h);
+    core.step(lotka_volterra, mj, x, h, 1e-14);
+  }
+}
+
+int main()
+{
+  double serial[2] = {1.0, 1.0};
+  const bench::result r_serial = bench::measure("serial rkgl<4>", 1, [&]
+                                                {
+                                                  serial[0] = serial[1] = 1.0;
+                                                  fine_integrate(serial, t_end);
+                                                  bench::do_not_optimize(serial[0]); }, 3);
+  bench::print(r_serial);
+
+  const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "hardware threads: " << hardware << "\n\n";
+
+  for (const size_t slices : {16, 32})
+  {
+    const double dt = t_end / double(slices);
+    for (const double h_coarse : {0.1, 0.05})
+    {
+      const int coarse_steps = int(std::ceil(dt / h_coarse - 1e-9));
+      Lotka_Voltera coarse_core;
+      auto coarse = [&](size_t, double *x)
+      {
+        coarse_core.x.assign(x, x + 2);
+        for (int i = 0; i < coarse_steps; ++i)
+          coarse_core.step(dt / coarse_steps);
+        std::copy(coarse_core.x.begin(), coarse_core.x.end(), x);
+      };
+      auto fine = [&](size_t, double *x)
+      { fine_integrate(x, dt); };
+
+      for (const size_t threads : {1, 4, 16})
+      {
+        math::thread_pool pool(threads);
+        std::vector<double> U(2 * (slices + 1));
+        math::parareal_stats<double> st;
+
+        const std::string name = std::to_string(slices) + " slices, G " + std::to_string(coarse_steps) +
+                                 " steps, " + std::to_string(threads) + " threads";
+        const bench::result r = bench::measure(name, 1, [&]
+                                               {
+                                                 U[0] = U[1] = 1.0;
+                                                 st = math::parareal(pool, 2, slices, U.data(), coarse, fine, 1e-10, slices);
+                                                 bench::do_not_optimize(U[0]); }, 3);
+
+        const double deviation = std::max(std::abs(U[2 * slices] - serial[0]), std::abs(U[2 * slices + 1] - serial[1]));
+        bench::print(r);
+        std::cout << std::setw(10) << st.iterations << " iterations, " << st.fine_solves << " fine slice solves"
+                  << std::scientific << std::setprecision(2) << ", deviation " << deviation << std::defaultfloat
+                  << std::fixed << std::setprecision(2) << ", speedup " << r_serial.seconds / r.seconds
+                  << " (bound " << double(slices) / double(st.fine_solves) * double(threads) << ")\n"
+                  << std::defaultfloat;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ling.hpp>
+#include <double_double.hpp>
+#include <qode1.hpp>
+#include <minijacobian.hpp>
+#include <bench.hpp>
+
+// Cost of the generic kernels per scalar type: float, double, long double
+// and math::double_double.
+
+template <class U>
+class Network : public qode::qode1_core<U>
+{
+public:
+  explicit Network(size_t size) : qode::qode1_core<U>(size) {};
+
+  void set_coef() override
+  {
+    const size_t n = this->dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      this->a_coef(i) = U(0.1);
+      this->b_coef(i, i) = U(-1.0);
+      this->b_coef(i, (i + 1) % n) = U(0.3);
+      this->c_coef(i, (i + 1) % n, (i + 2) % n) = U(-0.05);
+    }
+  }
+};
+
+template <class U>
+void run(const std::string &type)
+{
+  std::cout << type << "\n";
+
+  {
+    U A0[36], A[36], b[6];
+    for (size_t i = 0; i < 36; ++i)
+      A0[i] = U(0.01) * U(double(i % 5)) + (i % 7 == 0 ? U(1) : U(0));
+    bench::print(bench::measure("  solve_opt<6>", 100000, [&]
+                                {
+                                  std::copy(A0, A0 + 36, A);
+                                  for (size_t i = 0; i < 6; ++i)
+                                    b[i] = U(1);
+                                  math::solve_opt<6>(A, b);
+                                  bench::do_not_optimize(b[0]); }));
+  }
+
+  {
+    const size_t n = 64;
+    std::vector<U> A0(n * n), A(n * n), b(n);
+    for (size_t i = 0; i < n * n; ++i)
+      A0[i] = U(0.01) * U(double(i % 5)) + (i % (n + 1) == 0 ? U(1) : U(0));
+    bench::print(bench::measure("  lu_naive + fb_naive, n = 64", 200, [&]
+                                {
+                                  A = A0;
+                                  std::fill(b.begin(), b.end(), U(1));
+                                  math::lu_naive(n, A.data());
+                                  math::fb_naive(n, A.data(), b.data());
+                                  bench::do_not_optimize(b[0]); }));
+  }
+
+  {
+    Network<U> core(32);
+    core.x.assign(32, U(1));
+    bench::print(bench::measure("  qode1_core::step, n = 32", 2000, [&]
+                                { core.step(U(0.01)); bench::do_not_optimize(core.x[0]); }));
+  }
+
+  {
+    const size_t n = 1000;
+    rkgl::mini_jacobian<U> mj;
+    mj.set(n);
+    std::vector<U> x(n, U(1));
+    auto f = [n](const U *x, U *y)
+    {
+      for (size_t i = 0; i < n; ++i)
+        y[i] = x[(i + 1) % n] - x[i] * x[i];
+    };
+    bench::print(bench::measure("  mini_jacobian::evaluate, n = 1000", 2000, [&]
+                                { mj.evaluate(f, x.data(), U(0.01)); bench::do_not_optimize(mj); }));
+  }
+}
+
+int main()
+{
+  run<float>("float");
+  run<double>("double");
+  run<long double>("long double");
+  run<math::double_double>("double_double");
+
+  return 0;
+}
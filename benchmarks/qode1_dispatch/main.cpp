@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <qode1.hpp>
+#include <bench.hpp>
+
+// Cost of a qode1_core step for a runtime dimension n, with the kernel
+// selected by select_symmetric_kernel (solve_opt<n> for n <= 16,
+// lu_blocked above) against the generic symmetric_update
+// (lu_naive + fb_naive) used before. The model is a ring of coupled
+// Lotka-Volterra type cells, so the Jacobian is sparse but assembled dense.
+
+class Ring : public qode::qode1_core<double>
+{
+public:
+  explicit Ring(const size_t n) : qode::qode1_core<double>(n)
+  {
+    x.assign(n, 0.0);
+    for (size_t i = 0; i < n; ++i)
+      x[i] = 1.0 + 0.1 * double(i % 7);
+  }
+
+  void set_coef() override
+  {
+    const size_t n = dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      const size_t j = (i + 1) % n;
+      a_coef(i) = 0.1;
+      b_coef(i, i) = -0.5;
+      c_coef(i, i, j) = 0.05;
+      c_coef(i, j, j) = -0.02;
+    }
+  }
+
+  void step_generic(const double h)
+  {
+    prepare_step();
+    qode::symmetric_update(dim(), h, mat.data(), vec.data(), x.data());
+  }
+};
+
+void compare(const size_t n, const size_t iterations)
+{
+  Ring generic(n), dispatched(n);
+  const std::string suffix = ", n " + std::to_string(n);
+
+  const bench::result r_generic = bench::measure("symmetric_update" + suffix, iterations, [&]()
+                                                 { generic.step_generic(1e-3); bench::do_not_optimize(generic.x[0]); });
+  const bench::result r_dispatched = bench::measure("dispatched kernel" + suffix, iterations, [&]()
+                                                    { dispatched.step(1e-3); bench::do_not_optimize(dispatched.x[0]); });
+
+  bench::print(r_generic);
+  bench::print(r_dispatched);
+  bench::print_speedup(r_generic, r_dispatched);
+}
+
+int main()
+{
+  for (const size_t n : {2, 3, 4, 5, 6, 8, 10, 12, 16})
+    compare(n, 200000);
+  for (const size_t n : {32, 64, 128, 256, 512})
+    compare(n, 200000000 / (n * n * n) + 5);
+
+  return 0;
+}
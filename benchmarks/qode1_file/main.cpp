@@ -0,0 +1,79 @@
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <qode1_file.hpp>
+#include <bench.hpp>
+
+// Load time of random quadratic networks with 10^4 - 10^6 coefficients
+// from the binary model format (memory-mapped, indices validated) and from
+// the text format (parsed), plus the first step of qode1_mapped, which
+// touches every coefficient once.
+
+qode::qode1_coefficients<double> random_network(const size_t n, const size_t terms)
+{
+  qode::qode1_coefficients<double> net(n);
+  uint64_t state = 12345;
+  auto next = [&](const size_t range)
+  {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return size_t((state >> 33) % range);
+  };
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    net.a_coef(i, 0.1);
+    net.b_coef(i, i, -1.0);
+  }
+  for (size_t t = 2 * n; t < terms; t += 2)
+  {
+    const size_t i = next(n);
+    net.b_coef(i, next(n), 0.01);
+    net.c_coef(i, next(n), next(n), -0.001);
+  }
+  return net;
+}
+
+int main()
+{
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::string binary = (dir / "bench_qode1_file.q1b").string();
+  const std::string text = (dir / "bench_qode1_file.q1t").string();
+
+  for (size_t terms : {10000, 100000, 1000000})
+  {
+    const size_t n = 64;
+    const auto net = random_network(n, terms);
+    qode::write_binary(binary, net.terms());
+    qode::write_text(text, net.terms());
+
+    std::cout << "terms = " << terms << " (binary " << std::filesystem::file_size(binary) / 1024
+              << " KiB, text " << std::filesystem::file_size(text) / 1024 << " KiB)\n";
+
+    const size_t iters = terms <= 100000 ? 20 : 3;
+    auto r_binary = bench::measure("open binary (mmap)", iters, [&]
+                                   {
+                                     auto f = qode::qode1_file<double>::open(binary);
+                                     bench::do_not_optimize(f->terms().n); }, 3);
+    auto r_text = bench::measure("open text", iters, [&]
+                                 {
+                                   auto f = qode::qode1_file<double>::open(text);
+                                   bench::do_not_optimize(f->terms().n); }, 3);
+
+    auto file = qode::qode1_file<double>::open(binary);
+    qode::qode1_mapped<double> run(file);
+    run.x.assign(n, 1.0);
+    auto r_step = bench::measure("qode1_mapped::step", iters, [&]
+                                 {
+                                   run.step(0.01);
+                                   bench::do_not_optimize(run.x[0]); }, 3);
+
+    bench::print(r_binary);
+    bench::print(r_text);
+    bench::print(r_step);
+    bench::print_speedup(r_text, r_binary);
+  }
+
+  std::filesystem::remove(binary);
+  std::filesystem::remove(text);
+  return 0;
+}
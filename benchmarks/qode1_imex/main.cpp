@@ -0,0 +1,64 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <qode1.hpp>
+#include <bench.hpp>
+
+// Stiff linear network with mild quadratic coupling, integrated with fixed
+// steps by the implicit qode1 step (one factorisation per step) and by the
+// IMEX step (I - h/2 B factorised once, two substitutions per step).
+// Accuracy is measured against the implicit trajectory.
+
+class Network : public qode::qode1_core<double>
+{
+public:
+  explicit Network(size_t size) : qode::qode1_core<double>(size) {};
+
+  void set_coef() override
+  {
+    const size_t n = dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      a_coef(i) = 0.1;
+      b_coef(i, i) = -1.0 - 50.0 * double(i % 7);
+      for (size_t d = 1; d < n; d += 3)
+        b_coef(i, (i + d) % n) = 0.3 / double(d);
+      c_coef(i, (i + 1) % n, (i + 2) % n) = -0.05;
+    }
+  }
+};
+
+int main()
+{
+  for (size_t n : {16, 64, 128, 256})
+  {
+    const size_t steps = n <= 64 ? 2000 : 100;
+
+    Network implicit(n), imex(n);
+    imex.set_imex(true);
+    implicit.x.assign(n, 1.0);
+    imex.x.assign(n, 1.0);
+
+    std::cout << "n = " << n << "\n";
+    auto r_implicit = bench::measure("implicit", steps, [&]
+                                     {
+                                       implicit.step(0.01);
+                                       bench::do_not_optimize(implicit.x[0]); }, 1);
+    auto r_imex = bench::measure("imex", steps, [&]
+                                 {
+                                   imex.step(0.01);
+                                   bench::do_not_optimize(imex.x[0]); }, 1);
+
+    bench::print(r_implicit);
+    bench::print(r_imex);
+    bench::print_speedup(r_implicit, r_imex);
+
+    double err = 0;
+    for (size_t i = 0; i < n; ++i)
+      err = std::max(err, std::abs(imex.x[i] - implicit.x[i]));
+    std::cout << std::scientific << "  max deviation from implicit: " << err << "\n"
+              << std::defaultfloat;
+  }
+
+  return 0;
+}
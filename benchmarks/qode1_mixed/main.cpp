@@ -0,0 +1,76 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <qode1.hpp>
+#include <bench.hpp>
+
+// Large stiff quadratic network integrated with a double, a float and a
+// mixed double/float (float LU + iterative refinement) qode1_core.
+// Accuracy is measured against the pure double trajectory.
+
+template <class U, class Ufactor = U>
+class Network : public qode::qode1_core<U, Ufactor>
+{
+public:
+  explicit Network(size_t size) : qode::qode1_core<U, Ufactor>(size) {};
+
+  void set_coef() override
+  {
+    const size_t n = this->dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      this->a_coef(i) = U(0.1);
+      this->b_coef(i, i) = -U(1.0) - U(i % 7);
+      for (size_t d = 1; d < n; d += 3)
+        this->b_coef(i, (i + d) % n) = U(0.3) / U(d);
+      this->c_coef(i, (i + 1) % n, (i + 2) % n) = U(-0.05);
+    }
+  }
+};
+
+template <class Core>
+bench::result run(const char *name, Core &core, size_t n, size_t steps)
+{
+  return bench::measure(name, steps, [&]
+                        {
+                          core.x.assign(n, 1.0);
+                          core.step(0.05);
+                          bench::do_not_optimize(core.x[0]); }, 3);
+}
+
+int main()
+{
+  for (size_t n : {64, 128, 256, 512})
+  {
+    const size_t steps = n <= 128 ? 200 : 20;
+
+    Network<double> ref(n);
+    Network<float> single(n);
+    Network<double, float> mixed1(n), mixed2(n);
+    mixed1.refinement_steps = 1;
+    mixed2.refinement_steps = 2;
+
+    std::cout << "n = " << n << "\n";
+    auto r_ref = run("double", ref, n, steps);
+    auto r_single = run("float", single, n, steps);
+    auto r_mixed1 = run("double/float, 1 refinement", mixed1, n, steps);
+    auto r_mixed2 = run("double/float, 2 refinements", mixed2, n, steps);
+
+    for (auto *r : {&r_ref, &r_single, &r_mixed1, &r_mixed2})
+      bench::print(*r);
+    bench::print_speedup(r_ref, r_mixed2);
+
+    double e_single = 0, e_mixed1 = 0, e_mixed2 = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      e_single = std::max(e_single, std::abs(double(single.x[i]) - ref.x[i]));
+      e_mixed1 = std::max(e_mixed1, std::abs(mixed1.x[i] - ref.x[i]));
+      e_mixed2 = std::max(e_mixed2, std::abs(mixed2.x[i] - ref.x[i]));
+    }
+    std::cout << std::scientific << "  max deviation from double: float " << e_single
+              << ", 1 refinement " << e_mixed1 << ", 2 refinements " << e_mixed2 << "\n"
+              << std::defaultfloat;
+  }
+
+  return 0;
+}
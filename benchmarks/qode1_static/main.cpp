@@ -0,0 +1,66 @@
+#include <iostream>
+#include <qode1.hpp>
+#include <qode1_static.hpp>
+#include <bench.hpp>
+
+// Lotka-Volterra model from examples/lotka_volterra, once through the virtual
+// set_coef() path of qode1_core and once as a compile-time qode1_static model.
+
+class Lotka_Voltera : public qode::qode1_core<double>
+{
+public:
+  Lotka_Voltera() : qode::qode1_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+using lotka_volterra_model = qode::static_model<2,
+                                                qode::b_term<0, 0, 2.0 / 3.0>,
+                                                qode::b_term<1, 1, -1.0>,
+                                                qode::c_term<0, 0, 1, -4.0 / 3.0>,
+                                                qode::c_term<1, 0, 1, 1.0>>;
+
+int main()
+{
+  const size_t steps = 1000000;
+  const double mu = 0.03;
+
+  Lotka_Voltera dyn;
+  qode::qode1_static<double, lotka_volterra_model> fix;
+  dyn.x = {1.0, 1.0};
+  fix.x = {1.0, 1.0};
+
+  auto r_dyn = bench::measure("qode1_core::step", steps, [&]
+                              { dyn.step(1e-3); bench::do_not_optimize(dyn.x[0]); });
+  auto r_fix = bench::measure("qode1_static::step", steps, [&]
+                              { fix.step(1e-3); bench::do_not_optimize(fix.x[0]); });
+
+  dyn.x = {1.0, 1.0};
+  fix.x = {1.0, 1.0};
+  double h_dyn = dyn.suggest_first_stepsize(1.0, mu);
+  double h_fix = fix.suggest_first_stepsize(1.0, mu);
+
+  auto r_dyn_a = bench::measure("qode1_core::step_adaptive", steps, [&]
+                                { dyn.step_adaptive(h_dyn, mu); bench::do_not_optimize(dyn.x[0]); });
+  auto r_fix_a = bench::measure("qode1_static::step_adaptive", steps, [&]
+                                { fix.step_adaptive(h_fix, mu); bench::do_not_optimize(fix.x[0]); });
+
+  bench::print(r_dyn);
+  bench::print(r_fix);
+  bench::print(r_dyn_a);
+  bench::print(r_fix_a);
+  bench::print_speedup(r_dyn, r_fix);
+  bench::print_speedup(r_dyn_a, r_fix_a);
+
+  std::cout << std::scientific << "state difference after adaptive runs: "
+            << std::abs(dyn.x[0] - fix.x[0]) + std::abs(dyn.x[1] - fix.x[1]) << "\n";
+
+  return 0;
+}
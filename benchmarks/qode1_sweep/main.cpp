@@ -0,0 +1,96 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <qode1.hpp>
+#include <qode1_model.hpp>
+#include <bench.hpp>
+
+// Parameter sweep over a chain of coupled Lotka-Volterra pairs: one
+// qode1_core object per trajectory versus qode1_instance objects sharing a
+// single qode1_model.
+
+constexpr size_t pairs = 8;
+constexpr size_t chain_dim = 2 * pairs;
+
+class Chain : public qode::qode1_core<double>
+{
+public:
+  double alpha;
+
+  explicit Chain(double alpha) : qode::qode1_core<double>(chain_dim), alpha(alpha) {};
+
+  void set_coef() override
+  {
+    for (size_t p = 0; p < pairs; ++p)
+    {
+      const size_t i = 2 * p;
+      b_coef(i, i) = alpha;
+      b_coef(i + 1, i + 1) = -1.0;
+      c_coef(i, i, i + 1) = -4.0 / 3.0;
+      c_coef(i + 1, i, i + 1) = 1.0;
+      b_coef(i, (i + 2) % chain_dim) = 0.01;
+    }
+  }
+};
+
+std::shared_ptr<qode::qode1_model<double>> chain_model()
+{
+  auto model = std::make_shared<qode::qode1_model<double>>(chain_dim, 1);
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    model->b_param(i, i, 0);
+    model->b_coef(i + 1, i + 1, -1.0);
+    model->c_coef(i, i, i + 1, -4.0 / 3.0);
+    model->c_coef(i + 1, i, i + 1, 1.0);
+    model->b_coef(i, (i + 2) % chain_dim, 0.01);
+  }
+  return model;
+}
+
+int main()
+{
+  const size_t runs = 2000;
+  const size_t steps = 50;
+
+  auto model = chain_model();
+
+  std::vector<Chain> cores;
+  std::vector<qode::qode1_instance<double>> instances;
+  cores.reserve(runs);
+  instances.reserve(runs);
+
+  for (size_t r = 0; r < runs; ++r)
+  {
+    const double alpha = 0.5 + 0.5 * double(r) / double(runs);
+    cores.emplace_back(alpha);
+    cores.back().x.assign(chain_dim, 1.0);
+    instances.emplace_back(model);
+    instances.back().x.assign(chain_dim, 1.0);
+    instances.back().theta = {alpha};
+  }
+
+  auto r_core = bench::measure("qode1_core sweep (per run)", runs, [&, r = size_t(0)]() mutable
+                               {
+                                 auto &c = cores[r++ % runs];
+                                 for (size_t s = 0; s < steps; ++s)
+                                   c.step(1e-3);
+                                 bench::do_not_optimize(c.x[0]); });
+
+  auto r_inst = bench::measure("qode1_instance sweep (per run)", runs, [&, r = size_t(0)]() mutable
+                               {
+                                 auto &c = instances[r++ % runs];
+                                 for (size_t s = 0; s < steps; ++s)
+                                   c.step(1e-3);
+                                 bench::do_not_optimize(c.x[0]); });
+
+  bench::print(r_core);
+  bench::print(r_inst);
+  bench::print_speedup(r_core, r_inst);
+
+  const size_t bytes_core = sizeof(Chain) + sizeof(double) * (2 * chain_dim + chain_dim * chain_dim);
+  const size_t bytes_inst = sizeof(qode::qode1_instance<double>) + sizeof(double) * (chain_dim + 1);
+  std::cout << "bytes per trajectory: qode1_core " << bytes_core << ", qode1_instance " << bytes_inst << "\n";
+
+  return 0;
+}
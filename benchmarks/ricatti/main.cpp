@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include <qode1.hpp>
+#include <ricatti.hpp>
+#include <bench.hpp>
+
+// Robertson's stiff chemical network, a quadratic system with rate
+// constants spread over nine orders of magnitude:
+//
+//     x0' = -0.04 x0 + 1e4 x1 x2
+//     x1' =  0.04 x0 - 1e4 x1 x2 - 3e7 x1^2
+//     x2' =  3e7 x1^2
+//
+// integrated over t in [0, 40] with fixed stepsizes by qode1_core and by
+// ricatti_core. Reports the cost per step and the relative error of x0 and
+// x1 against a ricatti_core run with h = 1e-4.
+
+template <class Base>
+class Robertson : public Base
+{
+public:
+  Robertson() : Base(3) {};
+
+  void set_coef() override
+  {
+    this->b_coef(0, 0) = -0.04;
+    this->c_coef(0, 1, 2) = 1e4;
+
+    this->b_coef(1, 0) = 0.04;
+    this->c_coef(1, 1, 2) = -1e4;
+    this->c_coef(1, 1, 1) = -3e7;
+
+    this->c_coef(2, 1, 1) = 3e7;
+  }
+};
+
+constexpr double t_end = 40.0;
+
+template <class Core>
+void run(Core &core, const double h)
+{
+  core.x = {1.0, 0.0, 0.0};
+  const int steps = int(std::lround(t_end / h));
+  for (int i = 0; i < steps; ++i)
+    core.step(h);
+}
+
+int main()
+{
+  Robertson<qode::ricatti_core<double>> ref;
+  run(ref, 1e-4);
+
+  std::cout << std::left << std::setw(16) << "method" << std::right << std::setw(10) << "h"
+            << std::setw(14) << "err x0" << std::setw(14) << "err x1" << std::setw(14) << "ns/step" << "\n";
+
+  auto report = [&](const std::string &name, const double h, auto &core)
+  {
+    const size_t steps = size_t(std::lround(t_end / h));
+    const bench::result r = bench::measure(name, 1, [&]()
+                                           {
+                                             run(core, h);
+                                             bench::do_not_optimize(core.x[0]); },
+                                           3);
+    std::cout << std::left << std::setw(16) << name << std::right << std::scientific << std::setprecision(1)
+              << std::setw(10) << h << std::setprecision(3)
+              << std::setw(14) << std::abs(core.x[0] / ref.x[0] - 1.0)
+              << std::setw(14) << std::abs(core.x[1] / ref.x[1] - 1.0)
+              << std::fixed << std::setprecision(1) << std::setw(14) << r.ns_per_iteration() / double(steps) << "\n"
+              << std::defaultfloat;
+  };
+
+  for (const double h : {1e-3, 1e-2, 1e-1, 1.0})
+  {
+    Robertson<qode::qode1_core<double>> q;
+    report("qode1_core", h, q);
+    Robertson<qode::ricatti_core<double>> r;
+    report("ricatti_core", h, r);
+  }
+
+  return 0;
+}
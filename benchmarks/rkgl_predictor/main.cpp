@@ -0,0 +1,60 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <rkgl.hpp>
+#include <bench.hpp>
+
+// Stage sweeps per step and time of rkgl<double, order> on Lotka-Volterra
+// over t in [0, 20], with the extrapolating stage predictor and without it
+// (previous stage values as the initial guess).
+
+auto lotka_volterra = [](const double *x, double *y)
+{
+  y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+  y[1] = x[0] * x[1] - x[1];
+};
+
+constexpr double t_end = 20.0;
+
+template <int order>
+void compare(const double h, const double tol)
+{
+  const int steps = int(std::lround(t_end / h));
+
+  for (const bool predictor : {false, true})
+  {
+    rkgl::rkgl<double, order> core;
+    core.set(2);
+    core.predictor = predictor;
+    rkgl::mini_jacobian<double> mj;
+    mj.set(2);
+
+    const std::string name = "order " + std::to_string(2 * order) + ", h " + std::to_string(h).substr(0, 5) + (predictor ? ", predictor" : ", previous k");
+    double x[2];
+    const bench::result r = bench::measure(name, 1, [&]()
+                                           {
+                                             core.total_iterations = 0;
+                                             x[0] = x[1] = 1.0;
+                                             for (int i = 0; i < steps; ++i)
+                                             {
+                                               mj.evaluate(lotka_volterra, x, h);
+                                               core.step(lotka_volterra, mj, x, h, tol);
+                                             }
+                                             bench::do_not_optimize(x[0]); });
+
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << double(core.total_iterations) / steps << " sweeps/step"
+              << std::setw(12) << 1e-3 * r.ns_per_iteration() << " us\n"
+              << std::defaultfloat;
+  }
+}
+
+int main()
+{
+  compare<2>(0.1, 1e-14);
+  compare<3>(0.2, 1e-14);
+  compare<4>(0.4, 1e-14);
+  compare<6>(0.5, 1e-14);
+
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <chrono>
+#include <rkgl.hpp>
+#include <bench.hpp>
+
+// Work-precision diagram of rkgl<double, order> for orders 1..8 on the
+// Lotka-Volterra system over t in [0, 20]. Orders 4..8 use the tables
+// generated by gauss_legendre<U, order>().
+
+auto lotka_volterra = [](const double *x, double *y)
+{
+  y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+  y[1] = x[0] * x[1] - x[1];
+};
+
+constexpr double t_end = 20.0;
+
+template <int order>
+void integrate(double *x, const double h)
+{
+  rkgl::rkgl<double, order> core;
+  core.set(2);
+  rkgl::mini_jacobian<double> mj;
+  mj.set(2);
+
+  const int steps = int(std::lround(t_end / h));
+  for (int i = 0; i < steps; ++i)
+  {
+    mj.evaluate(lotka_volterra, x, h);
+    core.step(lotka_volterra, mj, x, h, 1e-15);
+  }
+}
+
+template <int order>
+void work_precision(const double *ref)
+{
+  for (double h : {0.5, 0.25, 0.125, 0.0625, 0.03125})
+  {
+    double x[2];
+    const auto start = std::chrono::steady_clock::now();
+    const int reps = 20;
+    for (int r = 0; r < reps; ++r)
+    {
+      x[0] = x[1] = 1.0;
+      integrate<order>(x, h);
+      bench::do_not_optimize(x[0]);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / reps;
+    const double err = std::hypot(x[0] - ref[0], x[1] - ref[1]);
+
+    std::cout << std::setw(6) << order << std::setw(10) << h
+              << std::scientific << std::setprecision(3)
+              << std::setw(14) << err << std::setw(14) << seconds << "\n"
+              << std::defaultfloat;
+  }
+}
+
+int main()
+{
+  double ref[2] = {1.0, 1.0};
+  integrate<8>(ref, 0.01);
+
+  std::cout << " order         h         error      time [s]\n";
+  work_precision<1>(ref);
+  work_precision<2>(ref);
+  work_precision<3>(ref);
+  work_precision<4>(ref);
+  work_precision<5>(ref);
+  work_precision<6>(ref);
+  work_precision<8>(ref);
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <qode1_model.hpp>
+#include <sensitivity.hpp>
+#include <bench.hpp>
+
+// Sensitivities of a chain of coupled Lotka-Volterra pairs with respect to
+// P growth rates: forward sensitivities sharing the LU factors of the state
+// step (qode1_sensitivity) versus forward differences with 1 + P
+// qode1_instance integrations.
+
+constexpr size_t pairs = 16;
+constexpr size_t chain_dim = 2 * pairs;
+
+std::shared_ptr<qode::qode1_model<double>> chain_model(const size_t n_params)
+{
+  auto model = std::make_shared<qode::qode1_model<double>>(chain_dim, n_params);
+  for (size_t p = 0; p < pairs; ++p)
+  {
+    const size_t i = 2 * p;
+    model->b_param(i, i, p % n_params);
+    model->b_coef(i + 1, i + 1, -1.0);
+    model->c_coef(i, i, i + 1, -4.0 / 3.0);
+    model->c_coef(i + 1, i, i + 1, 1.0);
+    model->b_coef(i, (i + 2) % chain_dim, 0.01);
+  }
+  return model;
+}
+
+int main()
+{
+  const double h = 0.01;
+  const size_t steps = 200;
+
+  for (const size_t n_params : {1, 4, 16})
+  {
+    auto model = chain_model(n_params);
+    const std::vector<double> theta(n_params, 2.0 / 3.0);
+
+    qode::qode1_sensitivity<double> sens(model);
+    const bench::result r_sens = bench::measure("sensitivities, P = " + std::to_string(n_params), 1, [&]()
+                                                {
+                                                  sens.theta = theta;
+                                                  sens.x.assign(chain_dim, 1.0);
+                                                  sens.reset_sensitivities();
+                                                  for (size_t i = 0; i < steps; ++i)
+                                                    sens.step(h);
+                                                  bench::do_not_optimize(sens.S[0]); });
+
+    qode::qode1_instance<double> run(model);
+    const bench::result r_fd = bench::measure("finite differences, P = " + std::to_string(n_params), 1, [&]()
+                                              {
+                                                for (size_t p = 0; p <= n_params; ++p)
+                                                {
+                                                  run.theta = theta;
+                                                  if (p > 0)
+                                                    run.theta[p - 1] += 1e-7;
+                                                  run.x.assign(chain_dim, 1.0);
+                                                  for (size_t i = 0; i < steps; ++i)
+                                                    run.step(h);
+                                                  bench::do_not_optimize(run.x[0]);
+                                                } });
+
+    bench::print(r_fd);
+    bench::print(r_sens);
+    bench::print_speedup(r_fd, r_sens);
+  }
+
+  return 0;
+}
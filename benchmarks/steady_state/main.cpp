@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <vector>
+#include <qode1.hpp>
+#include <steady_state.hpp>
+#include <bench.hpp>
+
+// Equilibrium of a dissipative quadratic network found by
+// steady_state_solver (PTC / Newton) and by integrating with step_adaptive
+// until |f(x)|_inf <= tol (residual checked every 10 steps).
+
+class Network : public qode::qode1_core<double>
+{
+public:
+  explicit Network(size_t size) : qode::qode1_core<double>(size) {};
+
+  void set_coef() override
+  {
+    const size_t n = dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      a_coef(i) = 0.1;
+      b_coef(i, i) = -1.0 - double(i % 7);
+      for (size_t d = 1; d < n; d += 3)
+        b_coef(i, (i + d) % n) = 0.3 / double(d);
+      c_coef(i, (i + 1) % n, (i + 2) % n) = -0.05;
+    }
+  }
+};
+
+double residual(Network &core)
+{
+  std::vector<double> f(core.dim());
+  core.evaluate(f.data());
+  double r = 0.0;
+  for (const double v : f)
+    r = std::max(r, std::abs(v));
+  return r;
+}
+
+int main()
+{
+  const double tol = 1e-10, mu = 0.3;
+
+  for (size_t n : {8, 32, 128})
+  {
+    Network solved(n), integrated(n);
+    qode::steady_state_solver<double> solver;
+    solver.tol = tol;
+    qode::steady_state_result<double> res;
+
+    const bench::result r_solver = bench::measure("steady_state_solver", 1, [&]
+                                                  {
+                                                    solved.x.assign(n, 1.0);
+                                                    res = solver.solve(solved);
+                                                    bench::do_not_optimize(solved.x[0]); }, 3);
+
+    size_t steps = 0;
+    const bench::result r_integrate = bench::measure("step_adaptive to convergence", 1, [&]
+                                                     {
+                                                       integrated.x.assign(n, 1.0);
+                                                       double h = integrated.suggest_first_stepsize(1.0, mu);
+                                                       steps = 0;
+                                                       while (steps < 1000000 && (steps % 10 != 0 || residual(integrated) > tol))
+                                                       {
+                                                         integrated.step_adaptive(h, mu);
+                                                         steps++;
+                                                       }
+                                                       bench::do_not_optimize(integrated.x[0]); }, 3);
+
+    double deviation = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      deviation = std::max(deviation, std::abs(solved.x[i] - integrated.x[i]));
+
+    std::cout << "n = " << n << "\n";
+    bench::print(r_solver);
+    std::cout << "  " << res.iterations << " iterations, " << res.factorizations << " factorizations, "
+              << res.fallback_steps << " fallback steps, residual " << std::scientific << std::setprecision(2)
+              << res.residual << std::defaultfloat << "\n";
+    bench::print(r_integrate);
+    std::cout << "  " << steps << " steps, max deviation " << std::scientific << std::setprecision(2)
+              << deviation << std::defaultfloat << "\n";
+    bench::print_speedup(r_integrate, r_solver);
+  }
+
+  return 0;
+}
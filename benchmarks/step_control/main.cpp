@@ -0,0 +1,91 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include <qode1.hpp>
+#include <composition.hpp>
+#include <step_control.hpp>
+#include <bench.hpp>
+
+// Lotka-Volterra over t in [0, 20]: stability-based step_adaptive(h, mu)
+// versus the Richardson error controller at several tolerances. Reports the
+// global error, the number of steps of the underlying integrator and time.
+
+class Lotka_Voltera : public qode::qode1_core<double>
+{
+public:
+  Lotka_Voltera() : qode::qode1_core<double>(2) {};
+
+  size_t steps = 0;
+
+  void set_coef() override
+  {
+    ++steps;
+
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+constexpr double t_end = 20.0;
+
+void report(const std::string &name, const double param, const double *ref, auto &&run)
+{
+  Lotka_Voltera core;
+  const bench::result r = bench::measure(name, 10, [&]()
+                                         {
+                                           core.x = {1.0, 1.0};
+                                           core.steps = 0;
+                                           run(core);
+                                           bench::do_not_optimize(core.x[0]); });
+  const double err = std::hypot(core.x[0] - ref[0], core.x[1] - ref[1]);
+
+  std::cout << std::left << std::setw(30) << name << std::right << std::scientific << std::setprecision(1)
+            << std::setw(10) << param << std::setprecision(3)
+            << std::setw(14) << err << std::setw(10) << core.steps
+            << std::setw(14) << 1e-9 * r.ns_per_iteration() << "\n"
+            << std::defaultfloat;
+}
+
+int main()
+{
+  double ref[2];
+  {
+    const qode::composition<double> c8(8, qode::composition_scheme::suzuki_fractal);
+    Lotka_Voltera core;
+    core.x = {1.0, 1.0};
+    for (int i = 0; i < 2000; ++i)
+      c8.step(core, 0.01);
+    ref[0] = core.x[0];
+    ref[1] = core.x[1];
+  }
+
+  std::cout << "method                           mu/tol         error     steps      time [s]\n";
+
+  for (double mu : {0.1, 0.03, 0.01, 0.003})
+    report("step_adaptive", mu, ref, [mu](Lotka_Voltera &core)
+           {
+             double h = core.suggest_first_stepsize(1.0, mu);
+             double t = 0.0;
+             while (t + h < t_end)
+             {
+               core.step_adaptive(h, mu);
+               t += h;
+             }
+             core.step(t_end - t); });
+
+  for (const bool extrapolate : {false, true})
+    for (double tol : {1e-4, 1e-6, 1e-8, 1e-10})
+      report(extrapolate ? "richardson (extrapolated)" : "richardson", tol, ref, [tol, extrapolate](Lotka_Voltera &core)
+             {
+               qode::richardson_controller<double> ctrl(tol, tol);
+               ctrl.extrapolate = extrapolate;
+               double h = 0.1, t = 0.0;
+               while (t < t_end)
+                 t += ctrl.step(core, h, t_end - t); });
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <qode1.hpp>
+#include <verlet.hpp>
+#include <composition.hpp>
+#include <bench.hpp>
+
+// Harmonic oscillator and a periodic chain of linearly coupled chain_particles:
+// the implicit qode1_core step versus explicit velocity Verlet and its
+// order 4 composition. Reports the cost per step and, for the single
+// oscillator, the phase space error at t = 10.
+
+constexpr size_t chain_particles = 64;
+
+class Oscillator_qode1 : public qode::qode1_core<double>
+{
+public:
+  Oscillator_qode1() : qode::qode1_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 1) = 1.0;
+    b_coef(1, 0) = -1.0;
+  }
+};
+
+class Oscillator_verlet : public qode::verlet<double, 1>
+{
+public:
+  void acceleration(const double x[], double a[]) override
+  {
+    a[0] = -x[0];
+  }
+};
+
+// x_i'' = x_{i-1} - 2 x_i + x_{i+1}
+class Chain_qode1 : public qode::qode1_core<double>
+{
+public:
+  Chain_qode1() : qode::qode1_core<double>(2 * chain_particles) {};
+
+  void set_coef() override
+  {
+    for (size_t i = 0; i < chain_particles; ++i)
+    {
+      b_coef(i, chain_particles + i) = 1.0;
+      b_coef(chain_particles + i, i) = -2.0;
+      b_coef(chain_particles + i, (i + 1) % chain_particles) = 1.0;
+      b_coef(chain_particles + i, (i + chain_particles - 1) % chain_particles) = 1.0;
+    }
+  }
+};
+
+class Chain_verlet : public qode::particle_system<double, 1>
+{
+public:
+  Chain_verlet() : qode::particle_system<double, 1>(chain_particles) {};
+
+  void acceleration(const double x[], double a[]) override
+  {
+    a[0] = x[chain_particles - 1] - 2.0 * x[0] + x[1];
+    for (size_t i = 1; i + 1 < chain_particles; ++i)
+      a[i] = x[i - 1] - 2.0 * x[i] + x[i + 1];
+    a[chain_particles - 1] = x[chain_particles - 2] - 2.0 * x[chain_particles - 1] + x[0];
+  }
+};
+
+int main()
+{
+  const double h = 0.01;
+  const int steps = 1000;
+  const qode::composition<double> c4(4, qode::composition_scheme::suzuki_fractal);
+
+  auto phase_error = [](const double x, const double u)
+  {
+    return std::hypot(x - std::cos(10.0), u + std::sin(10.0));
+  };
+
+  std::cout << "oscillator, h = " << h << ", t = 10, per run of " << steps << " steps\n";
+
+  Oscillator_qode1 q;
+  const bench::result rq = bench::measure("qode1_core", 1, [&]()
+                                          {
+                                            q.x = {1.0, 0.0};
+                                            for (int i = 0; i < steps; ++i)
+                                              q.step(h);
+                                            bench::do_not_optimize(q.x[0]); });
+
+  Oscillator_verlet v;
+  const bench::result rv = bench::measure("verlet", 1, [&]()
+                                          {
+                                            v.x = {1.0};
+                                            v.u = {0.0};
+                                            v.x_changed();
+                                            for (int i = 0; i < steps; ++i)
+                                              v.step(h);
+                                            bench::do_not_optimize(v.x[0]); });
+  const double ev = phase_error(v.x[0], v.u[0]);
+
+  Oscillator_verlet v4;
+  const bench::result rv4 = bench::measure("verlet + composition order 4", 1, [&]()
+                                           {
+                                             v4.x = {1.0};
+                                             v4.u = {0.0};
+                                             v4.x_changed();
+                                             for (int i = 0; i < steps; ++i)
+                                               v4.step(h, c4);
+                                             bench::do_not_optimize(v4.x[0]); });
+
+  for (const auto &[r, err] : {std::pair{rq, phase_error(q.x[0], q.x[1])}, std::pair{rv, ev}, std::pair{rv4, phase_error(v4.x[0], v4.u[0])}})
+  {
+    bench::print(r);
+    std::cout << "  error " << std::scientific << std::setprecision(3) << err << std::defaultfloat << "\n";
+  }
+  bench::print_speedup(rq, rv);
+
+  std::cout << "\nchain of " << chain_particles << " particles, per step\n";
+
+  Chain_qode1 cq;
+  cq.x.assign(2 * chain_particles, 0.0);
+  cq.x[0] = 1.0;
+  const bench::result rcq = bench::measure("qode1_core chain", 100, [&]()
+                                           {
+                                             cq.step(h);
+                                             bench::do_not_optimize(cq.x[0]); });
+
+  Chain_verlet cv;
+  cv.x[0] = 1.0;
+  const bench::result rcv = bench::measure("verlet chain", 100000, [&]()
+                                           {
+                                             cv.step(h);
+                                             bench::do_not_optimize(cv.x[0]); });
+
+  bench::print(rcq);
+  bench::print(rcv);
+  bench::print_speedup(rcq, rcv);
+
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <qode1.hpp>
+#include <trajectory.hpp>
 #include <fstream>
 
 int main()
@@ -27,13 +28,10 @@ int main()
 
     double h = core.suggest_first_stepsize(1.0, 0.03);
 
-    for (size_t i = 0; i < 500; ++i)
-    {
-        // core.step(0.1);
-        core.step_adaptive(h, 0.03);
-        // out << core.u[0] << " " << core.u[1] << std::endl;
-        out << h << std::endl;
-    }
+    // every 5th adaptive step up to t = 50, written on a separate thread
+    auto points = qode::decimate(qode::adaptive_trajectory(core, 0.0, 50.0, h, 0.03), 5);
+    qode::consume_async(std::move(points), 64, [&](const qode::trajectory_point<double> &p)
+                        { out << p.t << " " << p.h << " " << p.x[0] << " " << p.x[1] << "\n"; });
     out.close();
 
     return 0;
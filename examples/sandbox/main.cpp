@@ -4,19 +4,30 @@
 #include <minijacobian.hpp>
 #include <rkgl.hpp>
 
+class Oscillator : public qode::verlet<double, 1>
+{
+public:
+  void acceleration(const double x[], double a[]) override
+  {
+    a[0] = -x[0];
+  }
+};
+
 int main()
 {
 
-  //    Oscillator osc;
-  //    osc.x[0] = 1.0;
+  Oscillator osc;
+  osc.x[0] = 1.0;
 
-  //    std::ofstream out("trajectory.txt");
+  std::ofstream out("trajectory.txt");
+
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    out << osc.x[0] * osc.x[0] + osc.u[0] * osc.u[0] << std::endl;
+    osc.step(0.1);
+  }
+  out.close();
 
-  //    for(size_t i = 0; i< 1000; ++i) {
-  //        out << osc.x[0] * osc.x[0] + osc.u[0] * osc.u[0] << std::endl;
-  //        osc.step(0.1);
-  //    }
-  //    out.close();
   rkgl::rkgl<double, 3> core;
   core.set(2);
 
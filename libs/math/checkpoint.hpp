@@ -0,0 +1,195 @@
+// =============================================================================
+//  FILE: checkpoint.hpp  -  reverse sweeps over long trajectories
+// =============================================================================
+//
+//  An adjoint (reverse) sweep visits the states x_{N-1}, ..., x_0 of a
+//  forward integration in reverse order. Storing all of them costs O(N)
+//  memory. bisection_reverse stores only O(log N) of them and recomputes
+//  the rest:
+//
+//      reverse(x_a, a, b):
+//          if b - a == 1:  backward(x_a, a)
+//          else:           x_m = forward^(m - a)(x_a),  m = (a + b) / 2
+//                          reverse(x_m, m, b)
+//                          reverse(x_a, a, m)
+//
+//  At most ceil(log2 N) + 1 states are alive at a time and every step is
+//  recomputed about log2(N) / 2 times.
+//
+//  binomial_reverse does the same with a given number c of stored states
+//  (snapshots) and the schedule of binomial checkpointing (revolve,
+//  Griewank & Walther 2000), which needs the fewest forward steps possible
+//  for c snapshots:
+//
+//      forward steps = r N - beta(c + 1, r - 1),   beta(c, r) = (c + r)! / (c! r!),
+//
+//  where r, the largest number of times a step is recomputed, is the
+//  smallest integer with beta(c, r) >= N (binomial_forward_steps). Each
+//  level advances a copy of its snapshot by
+//
+//      j = max(beta(c, r - 2), N - beta(c - 1, r))
+//
+//  steps, reverses the last N - j steps with c - 1 snapshots and the first
+//  j with c; with a single snapshot the steps are recomputed from it one by
+//  one. With c = ceil(log2 N) snapshots (bisection_snapshots) it holds as
+//  many states as bisection and takes fewer forward steps, e.g. 3636
+//  instead of 4932 for N = 1000 (r = 4).
+//
+//  forward(State &x, size_t i) advances x from x_i to x_{i+1};
+//  backward(const State &x, size_t i) is the adjoint of step i, given x_i,
+//  and is called for i = N-1, ..., 0 in this order. checkpoint_stats counts
+//  the states held at a time (snapshots plus the one being advanced) and
+//  the forward steps of the recomputation.
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+namespace math
+{
+  struct checkpoint_stats
+  {
+    size_t peak_states = 0;
+    size_t forward_steps = 0;
+  };
+
+  namespace checkpoint_detail
+  {
+    template <class State, class Forward, class Backward>
+    void reverse(const State &x_a, const size_t a, const size_t b, const size_t depth,
+                 Forward &forward, Backward &backward, checkpoint_stats &stats)
+    {
+      stats.peak_states = stats.peak_states < depth ? depth : stats.peak_states;
+
+      if (b - a == 1)
+      {
+        backward(x_a, a);
+        return;
+      }
+
+      const size_t m = a + (b - a) / 2;
+      {
+        State x_m = x_a;
+        for (size_t i = a; i < m; i++)
+          forward(x_m, i);
+        stats.forward_steps += m - a;
+
+        reverse(x_m, m, b, depth + 1, forward, backward, stats);
+      }
+      reverse(x_a, a, m, depth, forward, backward, stats);
+    }
+
+    // beta(c, r) = (c + r)! / (c! r!), or cap + 1 if that is larger than cap
+    inline size_t beta(const size_t c, const size_t r, const size_t cap)
+    {
+      size_t b = 1;
+      for (size_t k = 1; k <= r; k++)
+      {
+        if (b > std::numeric_limits<size_t>::max() / (c + k))
+          return cap + 1;
+        b = b * (c + k) / k; // exact: beta(c, k) is an integer
+        if (b > cap)
+          return cap + 1;
+      }
+      return b;
+    }
+
+    // smallest r with beta(c, r) >= steps
+    inline size_t repetitions(const size_t steps, const size_t c)
+    {
+      size_t r = 0;
+      while (beta(c, r, steps) < steps)
+        r++;
+      return r;
+    }
+
+    // x_a is snapshot number depth of `snapshots`, the last one available
+    template <class State, class Forward, class Backward>
+    void binomial(const State &x_a, const size_t a, const size_t b, const size_t snapshots, const size_t depth,
+                  Forward &forward, Backward &backward, checkpoint_stats &stats)
+    {
+      stats.peak_states = stats.peak_states < depth ? depth : stats.peak_states;
+      const size_t l = b - a;
+
+      if (l == 1)
+      {
+        backward(x_a, a);
+        return;
+      }
+
+      const size_t c = snapshots - depth + 1;
+      if (c == 1)
+      {
+        stats.peak_states = stats.peak_states < depth + 1 ? depth + 1 : stats.peak_states;
+        for (size_t i = b; i-- > a;)
+        {
+          State x = x_a;
+          for (size_t k = a; k < i; k++)
+            forward(x, k);
+          stats.forward_steps += i - a;
+          backward(x, i);
+        }
+        return;
+      }
+
+      const size_t r = repetitions(l, c);
+      const size_t low = r >= 2 ? beta(c, r - 2, l) : 1;
+      const size_t from_end = beta(c - 1, r, l);
+      const size_t j = from_end < l && l - from_end > low ? l - from_end : low;
+
+      const size_t m = a + j;
+      {
+        State x_m = x_a;
+        for (size_t i = a; i < m; i++)
+          forward(x_m, i);
+        stats.forward_steps += j;
+
+        binomial(x_m, m, b, snapshots, depth + 1, forward, backward, stats);
+      }
+      binomial(x_a, a, m, snapshots, depth, forward, backward, stats);
+    }
+  }
+
+  // forward steps of binomial_reverse, the minimum for the given snapshots
+  inline size_t binomial_forward_steps(const size_t steps, const size_t snapshots)
+  {
+    if (steps < 2)
+      return 0;
+    if (snapshots <= 1)
+      return steps * (steps - 1) / 2;
+    const size_t r = checkpoint_detail::repetitions(steps, snapshots);
+    return r * steps - checkpoint_detail::beta(snapshots + 1, r - 1, r * steps);
+  }
+
+  // snapshots for which binomial_reverse holds as many states as
+  // bisection_reverse, ceil(log2 N)
+  inline size_t bisection_snapshots(const size_t steps)
+  {
+    size_t c = 1;
+    while (c < 8 * sizeof(size_t) && (size_t(1) << c) < steps)
+      c++;
+    return c;
+  }
+
+  template <class State, class Forward, class Backward>
+  inline checkpoint_stats bisection_reverse(const size_t steps, const State &x0, Forward &&forward, Backward &&backward)
+  {
+    checkpoint_stats stats;
+    if (steps > 0)
+      checkpoint_detail::reverse(x0, 0, steps, 1, forward, backward, stats);
+    return stats;
+  }
+
+  // snapshots >= 1 includes the copy of x0
+  template <class State, class Forward, class Backward>
+  inline checkpoint_stats binomial_reverse(const size_t steps, const size_t snapshots, const State &x0,
+                                           Forward &&forward, Backward &&backward)
+  {
+    checkpoint_stats stats;
+    if (steps > 0)
+      checkpoint_detail::binomial(x0, 0, steps, snapshots < 1 ? 1 : snapshots, 1, forward, backward, stats);
+    return stats;
+  }
+}
@@ -0,0 +1,266 @@
+// =============================================================================
+//  FILE: double_double.hpp  -  double-double arithmetic for reference runs
+// =============================================================================
+//
+//  math::double_double represents a number as the unevaluated sum hi + lo of
+//  two doubles with |lo| <= ulp(hi)/2, which gives about 106 significant bits
+//  (~32 decimal digits) using only hardware double operations.
+//
+//  The type is meant as a drop-in U for the templates of this project
+//  (qode1_core<U>, rkgl<U, order>, mini_jacobian<U>, math::solve_opt<n, U>):
+//  it provides the arithmetic and comparison operators, sqrt and abs found
+//  by argument dependent lookup, and a std::numeric_limits specialisation.
+//
+//  All basic operations are constexpr; products use Dekker's splitting, so
+//  the results do not depend on the availability of a hardware fma.
+//
+//  Algorithms follow Dekker (1971) and the QD library of Hida, Li, Bailey.
+// =============================================================================
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <compare>
+
+namespace math
+{
+  struct double_double
+  {
+    double hi = 0.0;
+    double lo = 0.0;
+
+    constexpr double_double() = default;
+    constexpr double_double(const double value) : hi(value), lo(0.0) {}
+    constexpr double_double(const double high, const double low) : hi(high), lo(low) {}
+
+    explicit constexpr operator double() const { return hi + lo; }
+    explicit constexpr operator float() const { return float(hi + lo); }
+    explicit constexpr operator long double() const { return static_cast<long double>(hi) + lo; }
+
+    constexpr double_double &operator+=(const double_double &b);
+    constexpr double_double &operator-=(const double_double &b);
+    constexpr double_double &operator*=(const double_double &b);
+    constexpr double_double &operator/=(const double_double &b);
+  };
+
+  // ---------------------------------------------------------------------------
+  //  error-free transformations
+  // ---------------------------------------------------------------------------
+
+  namespace dd_detail
+  {
+    // s + e == a + b exactly
+    constexpr double_double two_sum(const double a, const double b)
+    {
+      const double s = a + b;
+      const double bb = s - a;
+      return {s, (a - (s - bb)) + (b - bb)};
+    }
+
+    // s + e == a + b exactly, requires |a| >= |b|
+    constexpr double_double quick_two_sum(const double a, const double b)
+    {
+      const double s = a + b;
+      return {s, b - (s - a)};
+    }
+
+    constexpr double_double split(const double a)
+    {
+      const double t = 134217729.0 * a; // 2^27 + 1
+      const double hi = t - (t - a);
+      return {hi, a - hi};
+    }
+
+    // p + e == a * b exactly
+    constexpr double_double two_prod(const double a, const double b)
+    {
+      const double p = a * b;
+      const double_double as = split(a);
+      const double_double bs = split(b);
+      return {p, ((as.hi * bs.hi - p) + as.hi * bs.lo + as.lo * bs.hi) + as.lo * bs.lo};
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //  arithmetic
+  // ---------------------------------------------------------------------------
+
+  constexpr double_double operator-(const double_double &a)
+  {
+    return {-a.hi, -a.lo};
+  }
+
+  constexpr double_double operator+(const double_double &a, const double_double &b)
+  {
+    double_double s = dd_detail::two_sum(a.hi, b.hi);
+    const double_double t = dd_detail::two_sum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = dd_detail::quick_two_sum(s.hi, s.lo);
+    s.lo += t.lo;
+    return dd_detail::quick_two_sum(s.hi, s.lo);
+  }
+
+  constexpr double_double operator+(const double_double &a, const double b)
+  {
+    double_double s = dd_detail::two_sum(a.hi, b);
+    s.lo += a.lo;
+    return dd_detail::quick_two_sum(s.hi, s.lo);
+  }
+
+  constexpr double_double operator+(const double a, const double_double &b)
+  {
+    return b + a;
+  }
+
+  constexpr double_double operator-(const double_double &a, const double_double &b)
+  {
+    return a + (-b);
+  }
+
+  constexpr double_double operator-(const double_double &a, const double b)
+  {
+    return a + (-b);
+  }
+
+  constexpr double_double operator-(const double a, const double_double &b)
+  {
+    return (-b) + a;
+  }
+
+  constexpr double_double operator*(const double_double &a, const double_double &b)
+  {
+    double_double p = dd_detail::two_prod(a.hi, b.hi);
+    p.lo += a.hi * b.lo + a.lo * b.hi;
+    return dd_detail::quick_two_sum(p.hi, p.lo);
+  }
+
+  constexpr double_double operator*(const double_double &a, const double b)
+  {
+    double_double p = dd_detail::two_prod(a.hi, b);
+    p.lo += a.lo * b;
+    return dd_detail::quick_two_sum(p.hi, p.lo);
+  }
+
+  constexpr double_double operator*(const double a, const double_double &b)
+  {
+    return b * a;
+  }
+
+  constexpr double_double operator/(const double_double &a, const double_double &b)
+  {
+    const double q1 = a.hi / b.hi;
+    double_double r = a - b * q1;
+    const double q2 = r.hi / b.hi;
+    r -= b * q2;
+    const double q3 = r.hi / b.hi;
+    return dd_detail::quick_two_sum(q1, q2) + q3;
+  }
+
+  constexpr double_double operator/(const double_double &a, const double b)
+  {
+    return a / double_double(b);
+  }
+
+  constexpr double_double operator/(const double a, const double_double &b)
+  {
+    return double_double(a) / b;
+  }
+
+  constexpr double_double &double_double::operator+=(const double_double &b)
+  {
+    return *this = *this + b;
+  }
+
+  constexpr double_double &double_double::operator-=(const double_double &b)
+  {
+    return *this = *this - b;
+  }
+
+  constexpr double_double &double_double::operator*=(const double_double &b)
+  {
+    return *this = *this * b;
+  }
+
+  constexpr double_double &double_double::operator/=(const double_double &b)
+  {
+    return *this = *this / b;
+  }
+
+  // ---------------------------------------------------------------------------
+  //  comparison
+  // ---------------------------------------------------------------------------
+
+  constexpr bool operator==(const double_double &a, const double_double &b)
+  {
+    return a.hi == b.hi && a.lo == b.lo;
+  }
+
+  constexpr std::partial_ordering operator<=>(const double_double &a, const double_double &b)
+  {
+    if (a.hi != b.hi)
+      return a.hi <=> b.hi;
+    return a.lo <=> b.lo;
+  }
+
+  // ---------------------------------------------------------------------------
+  //  functions (found by argument dependent lookup)
+  // ---------------------------------------------------------------------------
+
+  constexpr double_double abs(const double_double &a)
+  {
+    return a.hi < 0.0 ? -a : a;
+  }
+
+  inline double_double sqrt(const double_double &a)
+  {
+    if (a.hi <= 0.0)
+      return double_double(std::sqrt(a.hi));
+
+    // one Newton step on top of the double approximation (Karp's trick)
+    const double x = 1.0 / std::sqrt(a.hi);
+    const double ax = a.hi * x;
+    return double_double(ax) + (a - dd_detail::two_prod(ax, ax)).hi * (x * 0.5);
+  }
+
+  inline double_double floor(const double_double &a)
+  {
+    const double hi = std::floor(a.hi);
+    if (hi != a.hi)
+      return double_double(hi);
+    return dd_detail::quick_two_sum(hi, std::floor(a.lo));
+  }
+
+  inline std::ostream &operator<<(std::ostream &os, const double_double &a)
+  {
+    // hi and lo are printed as an explicit sum to keep all digits
+    const auto precision = os.precision(17);
+    os << a.hi << (a.lo < 0.0 ? " - " : " + ") << std::abs(a.lo);
+    os.precision(precision);
+    return os;
+  }
+}
+
+template <>
+class std::numeric_limits<math::double_double>
+{
+public:
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_signed = true;
+  static constexpr bool is_integer = false;
+  static constexpr bool is_exact = false;
+  static constexpr bool has_infinity = true;
+  static constexpr bool has_quiet_NaN = true;
+  static constexpr int radix = 2;
+  static constexpr int digits = 106;
+  static constexpr int digits10 = 31;
+  static constexpr int max_digits10 = 33;
+
+  static constexpr math::double_double min() noexcept { return std::numeric_limits<double>::min() * 0x1p53; }
+  static constexpr math::double_double max() noexcept { return {std::numeric_limits<double>::max(), 0x1p970}; }
+  static constexpr math::double_double lowest() noexcept { return -max(); }
+  static constexpr math::double_double epsilon() noexcept { return 0x1p-104; }
+  static constexpr math::double_double infinity() noexcept { return std::numeric_limits<double>::infinity(); }
+  static constexpr math::double_double quiet_NaN() noexcept { return std::numeric_limits<double>::quiet_NaN(); }
+};
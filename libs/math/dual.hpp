@@ -0,0 +1,206 @@
+// =============================================================================
+//  FILE: dual.hpp  -  forward-mode dual numbers with several tangent lanes
+// =============================================================================
+//
+//  math::dual<U, N> carries a value v and N tangents d[0..N-1]. Every
+//  operation applies the chain rule to all lanes, so evaluating a function
+//  f : U^n -> U^n at the point x + eps_k dir_k (k < N) yields f(x) in the
+//  values and the exact Jacobian-vector products J(x) dir_k in the tangents,
+//  with one evaluation of f and without truncation error.
+//
+//  The type is meant for right-hand sides written as templates in the
+//  element type, e.g.
+//
+//      auto f = [](const auto *x, auto *y) { y[0] = x[1]; y[1] = -sin(x[0]); };
+//
+//  which then serve both the plain U and the dual instantiation (calls of
+//  sin, cos, exp, log, sqrt, abs must be unqualified, or preceded by
+//  `using std::sin;` etc., to be found by argument dependent lookup).
+//
+//  Comparisons look at the values only, so branches of f follow the primal
+//  evaluation.
+//
+//  jvp<N>(f, n, x, dirs, y, jv) is the convenience entry point: dirs and jv
+//  are row-major n x N (the N lanes of component i are contiguous).
+// =============================================================================
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <compare>
+#include <vector>
+
+namespace math
+{
+  template <class U, size_t N>
+  struct dual
+  {
+    U v = U(0);
+    U d[N] = {};
+
+    constexpr dual() = default;
+    constexpr dual(const U value) : v(value) {}
+
+    constexpr dual &operator+=(const dual &b) { return *this = *this + b; }
+    constexpr dual &operator-=(const dual &b) { return *this = *this - b; }
+    constexpr dual &operator*=(const dual &b) { return *this = *this * b; }
+    constexpr dual &operator/=(const dual &b) { return *this = *this / b; }
+
+    // -------------------------------------------------------------------------
+    //  arithmetic (hidden friends, so that U and literals convert implicitly)
+    // -------------------------------------------------------------------------
+
+    friend constexpr dual operator-(const dual &a)
+    {
+      dual r(-a.v);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = -a.d[k];
+      return r;
+    }
+
+    friend constexpr dual operator+(const dual &a, const dual &b)
+    {
+      dual r(a.v + b.v);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = a.d[k] + b.d[k];
+      return r;
+    }
+
+    friend constexpr dual operator-(const dual &a, const dual &b)
+    {
+      dual r(a.v - b.v);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = a.d[k] - b.d[k];
+      return r;
+    }
+
+    friend constexpr dual operator*(const dual &a, const dual &b)
+    {
+      dual r(a.v * b.v);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = a.d[k] * b.v + a.v * b.d[k];
+      return r;
+    }
+
+    friend constexpr dual operator/(const dual &a, const dual &b)
+    {
+      const U q = a.v / b.v;
+      dual r(q);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = (a.d[k] - q * b.d[k]) / b.v;
+      return r;
+    }
+
+    // products and quotients with a constant skip the zero tangents
+    friend constexpr dual operator*(const dual &a, const U b)
+    {
+      dual r(a.v * b);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = a.d[k] * b;
+      return r;
+    }
+
+    friend constexpr dual operator*(const U a, const dual &b)
+    {
+      return b * a;
+    }
+
+    friend constexpr dual operator/(const dual &a, const U b)
+    {
+      dual r(a.v / b);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = a.d[k] / b;
+      return r;
+    }
+
+    // -------------------------------------------------------------------------
+    //  comparison (values only)
+    // -------------------------------------------------------------------------
+
+    friend constexpr bool operator==(const dual &a, const dual &b)
+    {
+      return a.v == b.v;
+    }
+
+    friend constexpr auto operator<=>(const dual &a, const dual &b)
+    {
+      return a.v <=> b.v;
+    }
+
+    // -------------------------------------------------------------------------
+    //  functions (found by argument dependent lookup)
+    // -------------------------------------------------------------------------
+
+    // g(a) from g(a.v) = value, g'(a.v) = slope
+    static constexpr dual chain_rule(const dual &a, const U value, const U slope)
+    {
+      dual r(value);
+      for (size_t k = 0; k < N; ++k)
+        r.d[k] = slope * a.d[k];
+      return r;
+    }
+
+    friend dual sqrt(const dual &a)
+    {
+      using std::sqrt;
+      const U s = sqrt(a.v);
+      return chain_rule(a, s, U(1) / (2 * s));
+    }
+
+    friend dual exp(const dual &a)
+    {
+      using std::exp;
+      const U e = exp(a.v);
+      return chain_rule(a, e, e);
+    }
+
+    friend dual log(const dual &a)
+    {
+      using std::log;
+      return chain_rule(a, log(a.v), U(1) / a.v);
+    }
+
+    friend dual sin(const dual &a)
+    {
+      using std::cos;
+      using std::sin;
+      return chain_rule(a, sin(a.v), cos(a.v));
+    }
+
+    friend dual cos(const dual &a)
+    {
+      using std::cos;
+      using std::sin;
+      return chain_rule(a, cos(a.v), -sin(a.v));
+    }
+
+    friend constexpr dual abs(const dual &a)
+    {
+      return a.v < U(0) ? -a : a;
+    }
+  };
+
+  // y = f(x) and jv = J(x) dirs for the N directions in dirs, both row-major
+  // n x N, by a single evaluation of f with dual<U, N>
+  template <size_t N, class U, class F>
+  inline void jvp(F &&f, const size_t n, const U *x, const U *dirs, U *y, U *jv)
+  {
+    std::vector<dual<U, N>> xd(n), yd(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      xd[i].v = x[i];
+      for (size_t k = 0; k < N; ++k)
+        xd[i].d[k] = dirs[N * i + k];
+    }
+
+    f(static_cast<const dual<U, N> *>(xd.data()), yd.data());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      y[i] = yd[i].v;
+      for (size_t k = 0; k < N; ++k)
+        jv[N * i + k] = yd[i].d[k];
+    }
+  }
+}
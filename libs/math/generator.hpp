@@ -0,0 +1,129 @@
+// =============================================================================
+//  FILE: generator.hpp  -  minimal lazy coroutine generator (C++20)
+// =============================================================================
+//
+//  math::generator<T> is the return type of a coroutine that produces a
+//  sequence of T with co_yield and is consumed as an input range:
+//
+//      math::generator<int> count(int n)
+//      {
+//        for (int i = 0; i < n; ++i)
+//          co_yield i;
+//      }
+//
+//      for (const int &i : count(3)) ...
+//
+//  The coroutine runs only when the consumer advances. co_yield stores the
+//  address of the yielded object, no copy: the reference from operator* is
+//  valid until the next increment. Leaving the loop early destroys the
+//  suspended coroutine with its locals. Exceptions thrown by the coroutine
+//  propagate from begin() or operator++.
+//
+//  (std::generator arrives with C++23; this covers what ode-lab needs.)
+// =============================================================================
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace math
+{
+  template <class T>
+  class generator
+  {
+  public:
+    struct promise_type
+    {
+      const T *value = nullptr;
+      std::exception_ptr error;
+
+      generator get_return_object() { return generator(handle::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() { error = std::current_exception(); }
+
+      std::suspend_always yield_value(const T &v) noexcept
+      {
+        value = std::addressof(v);
+        return {};
+      }
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    struct sentinel
+    {
+    };
+
+    class iterator
+    {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using difference_type = std::ptrdiff_t;
+      using value_type = T;
+
+      iterator() = default;
+      explicit iterator(const handle h) : coro(h) {}
+
+      const T &operator*() const { return *coro.promise().value; }
+      const T *operator->() const { return coro.promise().value; }
+
+      iterator &operator++()
+      {
+        resume(coro);
+        return *this;
+      }
+
+      void operator++(int) { ++*this; }
+
+      friend bool operator==(const iterator &it, sentinel) { return it.coro.done(); }
+
+    private:
+      handle coro;
+    };
+
+    generator(generator &&other) noexcept : coro(std::exchange(other.coro, nullptr)) {}
+
+    generator &operator=(generator &&other) noexcept
+    {
+      if (this != &other)
+      {
+        if (coro)
+          coro.destroy();
+        coro = std::exchange(other.coro, nullptr);
+      }
+      return *this;
+    }
+
+    ~generator()
+    {
+      if (coro)
+        coro.destroy();
+    }
+
+    iterator begin()
+    {
+      resume(coro);
+      return iterator(coro);
+    }
+
+    sentinel end() { return {}; }
+
+  private:
+    handle coro;
+
+    explicit generator(const handle h) : coro(h) {}
+
+    static void resume(const handle h)
+    {
+      h.resume();
+      if (h.done() && h.promise().error)
+        std::rethrow_exception(h.promise().error);
+    }
+  };
+}
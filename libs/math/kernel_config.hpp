@@ -0,0 +1,134 @@
+// =============================================================================
+//  FILE: kernel_config.hpp  -  per-host thresholds of the dense solve kernels
+// =============================================================================
+//
+//  The dense solves of the qode1 step have three backends whose crossover
+//  points depend on the CPU:
+//
+//      n <= fixed_max                fixed-size kernel (solve_opt<n> and
+//                                    unrolled loops, n <= 16)
+//      fixed_max < n < blocked_min   lu_naive
+//      n >= blocked_min              lu_blocked(n, A, block)
+//
+//  kernel_thresholds_for<U>() returns the thresholds for the scalar type U.
+//  The compiled-in defaults reproduce the fixed dispatch (every n <= 16 on
+//  a fixed-size kernel, lu_blocked with block 32 above). On first use the
+//  file named by the environment variable ODE_LAB_KERNEL_CONFIG is read,
+//  if set; load_kernel_config(path) reads one explicitly. The file, as
+//  written by the ode_lab_autotune tool, has one line per scalar type
+//
+//      # type  fixed_max  blocked_min  block
+//      double  16         72           32
+//
+//  with types float, double and long_double; other lines are ignored.
+//  Integrators choose their kernel at construction, so the configuration
+//  must be loaded before they are created.
+// =============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace math
+{
+  struct kernel_thresholds
+  {
+    size_t fixed_max = 16;
+    size_t blocked_min = 17;
+    size_t block = 32;
+  };
+
+  inline constexpr size_t max_fixed_kernel = 16;
+
+  // name of U in the configuration file, nullptr for types without an entry
+  template <class U>
+  constexpr const char *kernel_scalar_name()
+  {
+    if constexpr (std::is_same_v<U, float>)
+      return "float";
+    else if constexpr (std::is_same_v<U, double>)
+      return "double";
+    else if constexpr (std::is_same_v<U, long double>)
+      return "long_double";
+    else
+      return nullptr;
+  }
+
+  namespace kernel_detail
+  {
+    template <class U>
+    inline kernel_thresholds current{};
+
+    template <class U>
+    bool assign(const std::string &name, const kernel_thresholds &t)
+    {
+      if (kernel_scalar_name<U>() == nullptr || name != kernel_scalar_name<U>())
+        return false;
+      current<U> = t;
+      return true;
+    }
+  }
+
+  // reads thresholds from `in`, returns the number of entries applied
+  inline size_t load_kernel_config(std::istream &in)
+  {
+    size_t applied = 0;
+    std::string line;
+    while (std::getline(in, line))
+    {
+      if (line.empty() || line[0] == '#')
+        continue;
+
+      std::istringstream fields(line);
+      std::string name;
+      kernel_thresholds t;
+      if (!(fields >> name >> t.fixed_max >> t.blocked_min >> t.block) || t.block == 0)
+        continue;
+      t.fixed_max = std::min(t.fixed_max, max_fixed_kernel);
+      t.blocked_min = std::max(t.blocked_min, t.fixed_max + 1);
+
+      applied += kernel_detail::assign<float>(name, t) || kernel_detail::assign<double>(name, t) ||
+                 kernel_detail::assign<long double>(name, t);
+    }
+    return applied;
+  }
+
+  inline size_t load_kernel_config(const std::string &path)
+  {
+    std::ifstream in(path);
+    return in ? load_kernel_config(in) : 0;
+  }
+
+  template <class U>
+  void write_kernel_config(std::ostream &out, const kernel_thresholds &t)
+  {
+    out << kernel_scalar_name<U>() << ' ' << t.fixed_max << ' ' << t.blocked_min << ' ' << t.block << '\n';
+  }
+
+  // true if ODE_LAB_KERNEL_CONFIG named a readable configuration; the file
+  // is read once, on the first call
+  inline bool kernel_config_from_environment()
+  {
+    static const bool loaded = []
+    {
+      const char *path = std::getenv("ODE_LAB_KERNEL_CONFIG");
+      return path && load_kernel_config(std::string(path)) > 0;
+    }();
+    return loaded;
+  }
+
+  template <class U>
+  const kernel_thresholds &kernel_thresholds_for()
+  {
+    kernel_config_from_environment();
+    return kernel_detail::current<U>;
+  }
+}
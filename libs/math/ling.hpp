@@ -6,6 +6,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <algorithm>
 
 namespace math
 {
@@ -49,6 +50,72 @@ namespace math
     }
   }
 
+  // ---------------------------------------------------------------------------
+  //  lu_blocked
+  // ---------------------------------------------------------------------------
+  //  Same factorisation and storage as lu_naive, organised in panels of
+  //  `block` columns: factor the panel, solve for the block row of U, then
+  //  update the trailing matrix with the panel rows kept in cache, four of
+  //  them per sweep over a trailing row. The subtractions reach every
+  //  element in the same order as in lu_naive, so the factors agree with
+  //  it to the last bit.
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void lu_blocked(const size_t n, U A[], const size_t block = 32)
+  {
+    for (size_t k0 = 0; k0 < n; k0 += block)
+    {
+      const size_t k1 = std::min(n, k0 + block);
+
+      // panel: columns k0..k1 of rows k0..n
+      for (size_t i = k0; i < k1; i++)
+      {
+        const size_t row_i = n * i;
+        A[row_i + i] = 1 / A[row_i + i];
+        const U a_ii = A[row_i + i];
+        for (size_t j = i + 1; j < n; j++)
+        {
+          const size_t row_j = n * j;
+          A[row_j + i] *= a_ii;
+          const U a_ji = A[row_j + i];
+          for (size_t k = i + 1; k < k1; k++)
+            A[row_j + k] -= a_ji * A[row_i + k];
+        }
+      }
+
+      // block row of U: columns k1..n of rows k0..k1
+      for (size_t i = k0 + 1; i < k1; i++)
+        for (size_t p = k0; p < i; p++)
+        {
+          const U a_ip = A[n * i + p];
+          for (size_t k = k1; k < n; k++)
+            A[n * i + k] -= a_ip * A[n * p + k];
+        }
+
+      // trailing matrix, four panel rows per sweep over row j
+      for (size_t j = k1; j < n; j++)
+      {
+        U *a_j = A + n * j;
+        size_t p = k0;
+        for (; p + 4 <= k1; p += 4)
+        {
+          const U l0 = a_j[p], l1 = a_j[p + 1], l2 = a_j[p + 2], l3 = a_j[p + 3];
+          const U *u0 = A + n * p, *u1 = u0 + n, *u2 = u1 + n, *u3 = u2 + n;
+          for (size_t k = k1; k < n; k++)
+            a_j[k] = (((a_j[k] - l0 * u0[k]) - l1 * u1[k]) - l2 * u2[k]) - l3 * u3[k];
+        }
+        for (; p < k1; p++)
+        {
+          const U l = a_j[p];
+          const U *u_p = A + n * p;
+          for (size_t k = k1; k < n; k++)
+            a_j[k] -= l * u_p[k];
+        }
+      }
+    }
+  }
+
   // ---------------------------------------------------------------------------
   //  fb_naive
   // ---------------------------------------------------------------------------
@@ -70,6 +137,227 @@ namespace math
     }
   }
 
+  // ---------------------------------------------------------------------------
+  //  fb_multi
+  // ---------------------------------------------------------------------------
+  //  Forward + backward substitution for A.X = V with m right-hand sides.
+  //  V is an n*m row-major matrix (row i holds component i of all right-hand
+  //  sides), so the inner loops run over contiguous memory and vectorise
+  //  across the right-hand sides. A must be factorised by lu_naive.
+  //  The solution overwrites V.
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void fb_multi(const size_t n, const size_t m, const U A[], U V[])
+  {
+    for (size_t i = 1; i < n; i++)
+    {
+      U *v_i = V + m * i;
+      for (size_t k = 0; k < i; k++)
+      {
+        const U a_ik = A[n * i + k];
+        const U *v_k = V + m * k;
+        for (size_t r = 0; r < m; r++)
+          v_i[r] -= a_ik * v_k[r];
+      }
+    }
+
+    for (size_t i = n; i--;)
+    {
+      U *v_i = V + m * i;
+      for (size_t k = i + 1; k < n; k++)
+      {
+        const U a_ik = A[n * i + k];
+        const U *v_k = V + m * k;
+        for (size_t r = 0; r < m; r++)
+          v_i[r] -= a_ik * v_k[r];
+      }
+      const U a_ii = A[(n + 1) * i];
+      for (size_t r = 0; r < m; r++)
+        v_i[r] *= a_ii;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //  fb_transposed
+  // ---------------------------------------------------------------------------
+  //  Solves the transposed system A^T.x = v with the factors of lu_naive,
+  //  i.e. U^T.y = v followed by L^T.x = y. Used by adjoint (reverse mode)
+  //  computations that reuse a forward factorisation.
+  //  The solution overwrites v
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void fb_transposed(const size_t n, const U A[], U v[])
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      const size_t row_i = n * i;
+      v[i] *= A[row_i + i];
+      const U v_i = v[i];
+      for (size_t j = i + 1; j < n; j++)
+        v[j] -= A[row_i + j] * v_i;
+    }
+
+    for (size_t i = n; i--;)
+    {
+      const size_t row_i = n * i;
+      const U v_i = v[i];
+      for (size_t j = 0; j < i; j++)
+        v[j] -= A[row_i + j] * v_i;
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //  solve_refined
+  // ---------------------------------------------------------------------------
+  //  Solves A.x = b given in precision U while the LU factorisation is done in
+  //  a lower precision L (e.g. float for double data). The low-precision
+  //  solution is improved by `refinements` steps of iterative refinement
+  //
+  //      r = b - A.x   (in U),     x <- x + (LU)^{-1} r   (in L),
+  //
+  //  which recovers the accuracy of U as long as A is well conditioned in L.
+  //  A is not modified, the solution overwrites b.
+  //  Workspace: lu (n*n elements of L), d (n elements of L),
+  //             rhs (n elements of U).
+  // ---------------------------------------------------------------------------
+
+  template <class L, class U>
+  inline void solve_refined(const size_t n, const U A[], U b[], L lu[], L d[], U rhs[], const int refinements)
+  {
+    for (size_t i = 0; i < n * n; i++)
+      lu[i] = L(A[i]);
+    lu_naive(n, lu);
+
+    for (size_t i = 0; i < n; i++)
+    {
+      rhs[i] = b[i];
+      d[i] = L(b[i]);
+    }
+    fb_naive(n, lu, d);
+    for (size_t i = 0; i < n; i++)
+      b[i] = U(d[i]);
+
+    for (int it = 0; it < refinements; it++)
+    {
+      for (size_t i = 0; i < n; i++)
+        d[i] = L(rhs[i] - dot_product(n, A + n * i, b));
+      fb_naive(n, lu, d);
+      for (size_t i = 0; i < n; i++)
+        b[i] += U(d[i]);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  //  mat_mult
+  // ---------------------------------------------------------------------------
+  //  C = A.B for n*n matrices; C must not alias A or B.
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void mat_mult(const size_t n, const U A[], const U B[], U C[])
+  {
+    for (size_t i = 0; i < n * n; i++)
+      C[i] = U(0);
+
+    for (size_t i = 0; i < n; i++)
+      for (size_t k = 0; k < n; k++)
+      {
+        const U a_ik = A[n * i + k];
+        for (size_t j = 0; j < n; j++)
+          C[n * i + j] += a_ik * B[n * k + j];
+      }
+  }
+
+  // ---------------------------------------------------------------------------
+  //  expm_pade
+  // ---------------------------------------------------------------------------
+  //  In-place matrix exponential A <- exp(A) by scaling and squaring with the
+  //  diagonal (6,6) Pade approximant:
+  //
+  //      A is scaled by 2^-s so that ||A||_inf <= 1/2,
+  //      exp(A) ~ D^{-1} N,   N = sum_k c_k A^k,  D = sum_k c_k (-A)^k,
+  //      and the result is squared s times.
+  //
+  //  For ||A||_inf <= 1/2 the Pade error is below 1e-17 and D is strictly
+  //  diagonally dominant, so lu_naive needs no pivoting.
+  //  Workspace: work (4*n*n elements).
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void expm_pade(const size_t n, U A[], U work[])
+  {
+    using std::abs;
+
+    U *P = work;
+    U *N = work + n * n;
+    U *D = work + 2 * n * n;
+    U *T = work + 3 * n * n;
+
+    U norm = U(0);
+    for (size_t i = 0; i < n; i++)
+    {
+      U row = U(0);
+      for (size_t j = 0; j < n; j++)
+        row += abs(A[n * i + j]);
+      norm = norm < row ? row : norm;
+    }
+
+    int squarings = 0;
+    U scale = U(1);
+    while (norm * scale > U(0.5))
+    {
+      scale /= 2;
+      squarings++;
+    }
+
+    const U c[7] = {U(1), U(1) / 2, U(5) / 44, U(1) / 66, U(1) / 792, U(1) / 15840, U(1) / 665280};
+
+    for (size_t i = 0; i < n * n; i++)
+    {
+      A[i] *= scale;
+      P[i] = A[i];
+      N[i] = c[1] * A[i];
+      D[i] = -c[1] * A[i];
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+      N[(n + 1) * i] += c[0];
+      D[(n + 1) * i] += c[0];
+    }
+
+    for (int k = 2; k <= 6; k++)
+    {
+      mat_mult(n, P, A, T);
+      const U sign = k % 2 == 0 ? U(1) : U(-1);
+      for (size_t i = 0; i < n * n; i++)
+      {
+        P[i] = T[i];
+        N[i] += c[k] * P[i];
+        D[i] += sign * c[k] * P[i];
+      }
+    }
+
+    // A = D^{-1} N column by column
+    lu_naive(n, D);
+    for (size_t j = 0; j < n; j++)
+    {
+      for (size_t i = 0; i < n; i++)
+        T[i] = N[n * i + j];
+      fb_naive(n, D, T);
+      for (size_t i = 0; i < n; i++)
+        A[n * i + j] = T[i];
+    }
+
+    for (int s = 0; s < squarings; s++)
+    {
+      mat_mult(n, A, A, T);
+      for (size_t i = 0; i < n * n; i++)
+        A[i] = T[i];
+    }
+  }
+
   // ---------------------------------------------------------------------------
   //  spectral_radius_estimate
   // ---------------------------------------------------------------------------
@@ -108,10 +396,13 @@ namespace math
 
     const U det2 = 2 * tr2 - tr1 * tr1;
 
+    using std::abs;
+    using std::sqrt;
+
     if (det2 < 0)
-      return std::sqrt(std::abs(tr2 / 2));
+      return sqrt(abs(tr2 / 2));
 
-    return (std::abs(tr1) + std::sqrt(det2)) / 2;
+    return (abs(tr1) + sqrt(det2)) / 2;
   }
 
   // ---------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+// =============================================================================
+//  FILE: parareal.hpp  -  parallel-in-time integration of one trajectory
+// =============================================================================
+//
+//  Parareal splits [t_0, t_N] into N slices with states U_0 .. U_N and
+//  combines a cheap coarse propagator G with an accurate fine propagator F:
+//
+//      U_{k+1} <- G(U_k)                                  (initial sweep)
+//      U_{k+1} <- G(U_k^new) + F(U_k^old) - G(U_k^old)    (per iteration)
+//
+//  The N fine solves of an iteration are independent and run on a
+//  math::thread_pool; the correction sweep is sequential but only calls G.
+//  After iteration j the first j + 1 slices equal the fine solution, so
+//  they are skipped, and at most N iterations reproduce the serial fine
+//  integration. With K iterations and P threads the fine work takes about
+//  K * N / P slice solves of wall-clock time against N serially.
+//
+//      math::thread_pool pool;
+//      std::vector<double> U(n * (N + 1));          // U_0 in U[0 .. n)
+//      auto st = math::parareal(pool, n, N, U.data(), coarse, fine, 1e-10, N);
+//
+//  coarse(k, x) and fine(k, x) advance the n values at x over slice k in
+//  place; fine is called concurrently from several threads. An iteration
+//  converges when the largest change of a slice state, relative to
+//  1 + |value|, is at most tol. parareal_stats::updates records that change
+//  per iteration for monitoring.
+// =============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <thread_pool.hpp>
+
+namespace math
+{
+  template <class U>
+  struct parareal_stats
+  {
+    size_t iterations = 0;
+    size_t fine_solves = 0;
+    size_t coarse_solves = 0;
+    bool converged = false;
+    std::vector<U> updates;
+  };
+
+  template <class U, class Coarse, class Fine>
+  parareal_stats<U> parareal(thread_pool &pool, const size_t n, const size_t slices, U states[],
+                             Coarse &&coarse, Fine &&fine, const U tol, const size_t max_iterations)
+  {
+    using std::abs;
+
+    parareal_stats<U> stats;
+    std::vector<U> g_old(n * slices), f_new(n * slices), g_new(n);
+
+    // initial coarse sweep; g_old[k] = G(U_k)
+    for (size_t k = 0; k < slices; k++)
+    {
+      U *g = g_old.data() + n * k;
+      std::copy(states + n * k, states + n * (k + 1), g);
+      coarse(k, g);
+      std::copy(g, g + n, states + n * (k + 1));
+    }
+    stats.coarse_solves = slices;
+
+    for (size_t first = 0; first < slices && stats.iterations < max_iterations; first++)
+    {
+      pool.parallel_for(slices - first, [&](const size_t j)
+                        {
+                          const size_t k = first + j;
+                          U *f = f_new.data() + n * k;
+                          std::copy(states + n * k, states + n * (k + 1), f);
+                          fine(k, f); });
+      stats.fine_solves += slices - first;
+
+      // U_first is final, so U_{first+1} = F(U_first) exactly
+      U update = U(0);
+      for (size_t k = first; k < slices; k++)
+      {
+        U *g = g_old.data() + n * k;
+        const U *f = f_new.data() + n * k;
+        U *next = states + n * (k + 1);
+
+        if (k > first)
+        {
+          std::copy(states + n * k, states + n * (k + 1), g_new.begin());
+          coarse(k, g_new.data());
+          stats.coarse_solves++;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+          const U value = k > first ? g_new[i] + f[i] - g[i] : f[i];
+          const U change = abs(value - next[i]) / (1 + abs(next[i]));
+          if (!(change <= update)) // propagates NaN, so a diverging run never converges
+            update = change;
+          next[i] = value;
+        }
+        if (k > first)
+          std::copy(g_new.begin(), g_new.end(), g);
+      }
+
+      stats.iterations++;
+      stats.updates.push_back(update);
+      if (update <= tol)
+      {
+        stats.converged = true;
+        break;
+      }
+    }
+
+    if (!stats.converged && stats.iterations == slices)
+      stats.converged = true;
+    return stats;
+  }
+}
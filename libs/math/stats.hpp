@@ -0,0 +1,196 @@
+// =============================================================================
+//  FILE: stats.hpp  -  compile-time switchable integrator statistics
+// =============================================================================
+//
+//  math::solver_stats is the statistics object attached to the integrators
+//  (qode1_core, qode1_instance, rkgl, mini_jacobian) as their public member
+//  `stats`. Its level is fixed at compile time by ODE_LAB_STATS (CMake cache
+//  variable of the same name):
+//
+//      0  (default)  nothing is recorded; the object is empty and every call
+//                    compiles to nothing
+//      1             event counters (steps, rhs evaluations, ...)
+//      2             counters plus steady_clock timers for the phases
+//                    assemble / linear_solve / spectral_estimate / rhs
+//
+//  linear_solve covers factorisation and substitution together: the step
+//  kernels of qode1 (symmetric_kernel) eliminate and back-substitute in one
+//  fused pass, so the two cannot be timed apart; the `factorizations` and
+//  `solves` counters still count them separately.
+//
+//  Recording from an integrator:
+//
+//      stats.count(math::counter::factorizations);
+//      {
+//        auto timer = stats.time(math::phase::linear_solve);
+//        ...                                  // timed until end of scope
+//      }
+//
+//  Reading: get(counter), seconds(phase), and write_json(os), which writes
+//  a single JSON object for monitoring, e.g.
+//
+//      {"level":2,"counters":{"steps":100,...},"seconds":{"assemble":1.2e-05,...}}
+//
+//  Level 1 costs an increment per event. Timers cost two steady_clock reads
+//  per timed region, some 20-50 ns each (about 180 ns per qode1_core step
+//  measured on a VM), which dominates steps of small systems (n <= 8).
+// =============================================================================
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+#ifndef ODE_LAB_STATS
+#define ODE_LAB_STATS 0
+#endif
+
+namespace math
+{
+  inline constexpr int stats_level = ODE_LAB_STATS;
+
+  enum class counter : size_t
+  {
+    steps,
+    rejected_steps,
+    rhs_evaluations,
+    assemblies,
+    factorizations,
+    solves,
+    iterations,
+    count_
+  };
+
+  enum class phase : size_t
+  {
+    assemble,
+    linear_solve,
+    spectral_estimate,
+    rhs,
+    count_
+  };
+
+  inline constexpr const char *counter_names[] = {"steps", "rejected_steps", "rhs_evaluations", "assemblies",
+                                                  "factorizations", "solves", "iterations"};
+  inline constexpr const char *phase_names[] = {"assemble", "linear_solve", "spectral_estimate", "rhs"};
+
+  inline constexpr size_t counter_count = size_t(counter::count_);
+  inline constexpr size_t phase_count = size_t(phase::count_);
+
+  // adds the time from construction to destruction to a phase accumulator;
+  // empty for levels below 2 (the user-provided destructor keeps
+  // `auto timer = stats.time(...)` free of unused-variable warnings)
+  template <bool enabled>
+  class phase_timer
+  {
+  public:
+    explicit phase_timer(double *) {}
+    ~phase_timer() {}
+  };
+
+  template <>
+  class phase_timer<true>
+  {
+  public:
+    explicit phase_timer(double *accumulator) : acc(accumulator), start(clock::now()) {}
+    ~phase_timer() { *acc += std::chrono::duration<double>(clock::now() - start).count(); }
+
+    phase_timer(const phase_timer &) = delete;
+    phase_timer &operator=(const phase_timer &) = delete;
+
+  private:
+    using clock = std::chrono::steady_clock;
+    double *acc;
+    clock::time_point start;
+  };
+
+  namespace stats_detail
+  {
+    // storage by level, so that level 0 leaves solver_stats an empty class
+    template <int level>
+    struct storage
+    {
+      std::array<size_t, counter_count> counts{};
+      std::array<double, phase_count> secs{};
+    };
+
+    template <>
+    struct storage<1>
+    {
+      std::array<size_t, counter_count> counts{};
+    };
+
+    template <>
+    struct storage<0>
+    {
+    };
+  }
+
+  template <int level = stats_level>
+  class solver_stats : private stats_detail::storage<level < 2 ? level : 2>
+  {
+  public:
+    static constexpr bool counting = level >= 1;
+    static constexpr bool timing = level >= 2;
+
+    void count(const counter c, const size_t k = 1)
+    {
+      if constexpr (counting)
+        this->counts[size_t(c)] += k;
+    }
+
+    [[nodiscard]] phase_timer<timing> time(const phase p)
+    {
+      if constexpr (timing)
+        return phase_timer<timing>(&this->secs[size_t(p)]);
+      else
+        return phase_timer<timing>(nullptr);
+    }
+
+    size_t get(const counter c) const
+    {
+      if constexpr (counting)
+        return this->counts[size_t(c)];
+      else
+        return 0;
+    }
+
+    double seconds(const phase p) const
+    {
+      if constexpr (timing)
+        return this->secs[size_t(p)];
+      else
+        return 0.0;
+    }
+
+    void reset()
+    {
+      if constexpr (counting)
+        this->counts.fill(0);
+      if constexpr (timing)
+        this->secs.fill(0.0);
+    }
+
+    void write_json(std::ostream &os) const
+    {
+      os << "{\"level\":" << level;
+      if constexpr (counting)
+      {
+        os << ",\"counters\":{";
+        for (size_t i = 0; i < counter_count; i++)
+          os << (i ? "," : "") << '"' << counter_names[i] << "\":" << this->counts[i];
+        os << '}';
+      }
+      if constexpr (timing)
+      {
+        os << ",\"seconds\":{";
+        for (size_t i = 0; i < phase_count; i++)
+          os << (i ? "," : "") << '"' << phase_names[i] << "\":" << this->secs[i];
+        os << '}';
+      }
+      os << '}';
+    }
+  };
+}
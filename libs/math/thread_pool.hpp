@@ -0,0 +1,150 @@
+// =============================================================================
+//  FILE: thread_pool.hpp  -  fixed pool of worker threads for parallel loops
+// =============================================================================
+//
+//  math::thread_pool(threads) starts threads - 1 workers; the calling thread
+//  is the last one. parallel_for(count, body) calls body(i) for
+//  i = 0 .. count-1, distributing the indices dynamically over all threads,
+//  and returns when every call has finished. The first exception thrown by
+//  body is rethrown in the caller after the loop has drained.
+//
+//  One parallel_for runs at a time; calling it from inside body deadlocks.
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace math
+{
+  class thread_pool
+  {
+  public:
+    explicit thread_pool(size_t threads = std::thread::hardware_concurrency());
+    ~thread_pool();
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    // number of threads taking part in parallel_for, the caller included
+    size_t size() const;
+
+    template <class F>
+    void parallel_for(const size_t count, F &&body);
+
+  private:
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, idle;
+
+    std::function<void(size_t)> job;
+    size_t job_count = 0;
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    size_t generation = 0, busy = 0;
+    bool stop = false;
+
+    void work();
+    void run_tasks();
+  };
+
+  // -------------------------------------------------------------------------
+  //  thread_pool implementation
+  // -------------------------------------------------------------------------
+
+  inline thread_pool::thread_pool(size_t threads)
+  {
+    threads = threads ? threads : 1;
+    for (size_t t = 1; t < threads; t++)
+      workers.emplace_back([this]
+                           { work(); });
+  }
+
+  inline thread_pool::~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    wake.notify_all();
+    for (std::thread &w : workers)
+      w.join();
+  }
+
+  inline size_t thread_pool::size() const
+  {
+    return workers.size() + 1;
+  }
+
+  template <class F>
+  inline void thread_pool::parallel_for(const size_t count, F &&body)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m);
+      // workers woken late for the previous loop may still be looking at it
+      idle.wait(lock, [this]
+                { return busy == 0; });
+      job = [&body](const size_t i)
+      { body(i); };
+      job_count = count;
+      next.store(0);
+      error = nullptr;
+      ++generation;
+    }
+    wake.notify_all();
+
+    run_tasks();
+
+    std::unique_lock<std::mutex> lock(m);
+    idle.wait(lock, [this]
+              { return busy == 0; });
+    job = nullptr;
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  inline void thread_pool::work()
+  {
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(m);
+    while (true)
+    {
+      wake.wait(lock, [&]
+                { return stop || generation != seen; });
+      if (stop)
+        return;
+
+      seen = generation;
+      ++busy;
+      lock.unlock();
+      run_tasks();
+      lock.lock();
+      if (--busy == 0)
+        idle.notify_all();
+    }
+  }
+
+  inline void thread_pool::run_tasks()
+  {
+    for (size_t i = next.fetch_add(1); i < job_count; i = next.fetch_add(1))
+    {
+      try
+      {
+        job(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(m);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <ling.hpp>
+#include <checkpoint.hpp>
+#include <qode1.hpp>
+#include <qode1_model.hpp>
+
+// =============================================================================
+//  FILE: adjoint.hpp  -  discrete adjoint of the qode1 step
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  qode1_adjoint<U> is a qode1_instance<U> that computes the gradient of a
+//  scalar loss L(x_0, ..., x_N) of a fixed-step trajectory with respect to
+//  all parameters theta of its qode1_model and to the initial state, at a
+//  cost independent of the number of parameters (cf. qode1_sensitivity,
+//  whose cost grows with P).
+//
+//
+//  Adjoint step
+//  ------------
+//  The step M(x_n) x_{n+1} = x_n + h (A + B.x_n/2), M(x) = I - h/2 J(x),
+//  has the derivatives (see sensitivity.hpp)
+//
+//      dx_{n+1}/dx_n = M(x_n)^{-1} (I + h/2 J(x_{n+1})),
+//      dx_{n+1}/dtheta = M(x_n)^{-1} G_n,
+//
+//  so with lambda_{n+1} = dL/dx_{n+1} the reverse step is
+//
+//      mu        = M(x_n)^{-T} lambda_{n+1}          (math::fb_transposed)
+//      lambda_n  = mu + h/2 J(x_{n+1})^T mu  (+ dL/dx_n)
+//      grad     += G_n^T mu                           (qode1_model::parameter_vjp)
+//
+//  using the LU factors of the recomputed forward step.
+//
+//
+//  Checkpointing
+//  -------------
+//  gradient(steps, h, dl_dx) runs the forward integration, then the reverse
+//  sweep with math::binomial_reverse (revolve) with `snapshots` stored
+//  states; 0 selects ceil(log2 N), which keeps O(log N) states alive and
+//  recomputes each step fewer than log2(N) / 2 times.
+//
+//  dl_dx(i, x_i, lambda) must add dL/dx_i to lambda. It is called for
+//  i = N, N-1, ..., 0. On return `lambda` holds dL/dx_0, `grad` holds
+//  dL/dtheta and `x` holds x_N.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class qode1_adjoint : public qode1_instance<U>
+  {
+  public:
+    std::vector<U> lambda, grad;
+    size_t snapshots = 0; // 0: math::bisection_snapshots(steps)
+    math::checkpoint_stats checkpoint; // of the last gradient()
+
+    explicit qode1_adjoint(std::shared_ptr<const qode1_model<U>> model);
+
+    // with x == x_n: lambda <- dx_{n+1}/dx_n^T lambda, grad += dx_{n+1}/dtheta^T lambda;
+    // leaves x == x_{n+1}
+    void adjoint_step(const U h);
+
+    template <class LossGradient>
+    void gradient(const size_t steps, const U h, LossGradient &&dl_dx);
+
+  private:
+    std::vector<U> x0, lu, mu;
+  };
+
+  // -------------------------------------------------------------------------
+  //  qode1_adjoint<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_adjoint<U>::qode1_adjoint(std::shared_ptr<const qode1_model<U>> model)
+      : qode1_instance<U>(std::move(model))
+  {
+    const size_t n = this->dim();
+    x0.resize(n);
+    lu.resize(n * n);
+    mu.resize(n);
+    lambda.assign(n, U(0));
+    grad.assign(this->model->params(), U(0));
+  }
+
+  template <class U>
+  inline void qode1_adjoint<U>::adjoint_step(const U h)
+  {
+    const size_t n = this->dim();
+    typename qode1_instance<U>::workspace &ws = this->prepare_step();
+
+    // forward step; the LU factors of M(x_n) are left in lu (not in the
+    // workspace, which all instances on the thread share)
+    std::copy(this->x.begin(), this->x.end(), x0.begin());
+    std::copy(ws.mat.begin(), ws.mat.end(), lu.begin());
+    symmetric_update(n, h, lu.data(), ws.vec.data(), this->x.data());
+
+    std::copy(lambda.begin(), lambda.end(), mu.begin());
+    math::fb_transposed(n, lu.data(), mu.data());
+
+    // J(x_{n+1})^T mu
+    this->model->assemble(ws.theta_ext.data(), this->x.data(), ws.mat.data(), ws.vec.data());
+    std::copy(mu.begin(), mu.end(), lambda.begin());
+    for (size_t i = 0; i < n; i++)
+    {
+      const U c = h / 2 * mu[i];
+      for (size_t j = 0; j < n; j++)
+        lambda[j] += c * ws.mat[n * i + j];
+    }
+
+    this->model->parameter_vjp(h, x0.data(), this->x.data(), mu.data(), grad.data());
+  }
+
+  template <class U>
+  template <class LossGradient>
+  inline void qode1_adjoint<U>::gradient(const size_t steps, const U h, LossGradient &&dl_dx)
+  {
+    const std::vector<U> start = this->x;
+
+    for (size_t i = 0; i < steps; i++)
+      this->step(h);
+    const std::vector<U> end = this->x;
+
+    std::fill(lambda.begin(), lambda.end(), U(0));
+    std::fill(grad.begin(), grad.end(), U(0));
+    dl_dx(steps, static_cast<const U *>(end.data()), lambda.data());
+
+    auto forward = [&](std::vector<U> &state, size_t)
+    {
+      this->x.swap(state);
+      this->step(h);
+      this->x.swap(state);
+    };
+
+    auto backward = [&](const std::vector<U> &state, size_t i)
+    {
+      std::copy(state.begin(), state.end(), this->x.begin());
+      adjoint_step(h);
+      dl_dx(i, state.data(), lambda.data());
+    };
+
+    const size_t c = snapshots ? snapshots : math::bisection_snapshots(steps);
+    checkpoint = math::binomial_reverse(steps, c, start, forward, backward);
+    checkpoint.forward_steps += 2 * steps;
+    this->x = end;
+  }
+}
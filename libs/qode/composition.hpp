@@ -0,0 +1,206 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+// =============================================================================
+//  FILE: composition.hpp  -  higher order by symmetric composition
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  The qode1 step Phi_h is symmetric (Phi_h o Phi_{-h} = id) and of order 2,
+//  so its error expansion contains only odd powers of h. A symmetric product
+//
+//      Psi_h = Phi_{g_s h} o ... o Phi_{g_2 h} o Phi_{g_1 h},
+//      g_i = g_{s+1-i},  sum_i g_i = 1,
+//
+//  with suitable g_i cancels the leading error terms and reaches order
+//  4, 6 or 8 while staying symmetric. composition<U> holds such a set of
+//  substep coefficients and drives any integrator with
+//
+//      core.step(h)
+//      core.adapt_stepsize(h, mu, low_bound, high_bound)
+//
+//  (qode1_core, qode1_instance, qode1_static, ...).
+//
+//
+//  Schemes
+//  -------
+//    * triple_jump  (Yoshida 1990, Suzuki 1990): recursively
+//          Psi^{(p+2)}_h = Psi^{(p)}_{g1 h} o Psi^{(p)}_{g0 h} o Psi^{(p)}_{g1 h},
+//          g1 = 1 / (2 - 2^{1/(p+1)}),  g0 = 1 - 2 g1,
+//      3, 9, 27 substeps for order 4, 6, 8.
+//    * suzuki_fractal (Suzuki 1990): the same recursion with five substeps
+//          g1 = 1 / (4 - 4^{1/(p+1)}),  g0 = 1 - 4 g1,
+//      5, 25, 125 substeps for order 4, 6, 8; smaller error constants.
+//    * yoshida_optimal: Yoshida's 7 substep order 6 (solution A) and
+//      15 substep order 8 (solution D) methods.
+//
+//
+//  Stepsize control
+//  ----------------
+//  step_adaptive(core, h, mu, ...) applies the symmetric stepsize rule of
+//  qode1_core to the composed step as a whole, using mu / max_i |g_i|, so
+//  that spectral_radius * |g_i| h <= mu holds for every substep. The
+//  relation h_new * h_old = h_mid^2 is kept for the composed steps.
+//
+// =============================================================================
+
+namespace qode
+{
+  enum class composition_scheme
+  {
+    triple_jump,
+    suzuki_fractal,
+    yoshida_optimal
+  };
+
+  template <class U>
+  class composition
+  {
+  public:
+    explicit composition(const int order, const composition_scheme scheme = composition_scheme::triple_jump);
+
+    int order() const;
+    size_t stages() const;
+    const std::vector<U> &coefficients() const;
+
+    template <class Core>
+    void step(Core &core, const U h) const;
+
+    template <class Core>
+    void step_adaptive(Core &core, U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0)) const;
+
+    template <class Core>
+    U suggest_first_stepsize(Core &core, const U h_max, const U mu) const;
+
+  private:
+    int p;
+    std::vector<U> gamma;
+    U gamma_max;
+
+    void recursive(const int target_order, const int substeps);
+    void symmetric(const std::vector<U> &half);
+  };
+
+  // -------------------------------------------------------------------------
+  //  composition<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline composition<U>::composition(const int order, const composition_scheme scheme) : p(order)
+  {
+    if (order < 2 || order % 2 != 0)
+      throw std::invalid_argument("composition: order must be even and at least 2");
+
+    switch (scheme)
+    {
+    case composition_scheme::triple_jump:
+      recursive(order, 3);
+      break;
+    case composition_scheme::suzuki_fractal:
+      recursive(order, 5);
+      break;
+    case composition_scheme::yoshida_optimal:
+      if (order == 6)
+        symmetric({U(-1.17767998417887), U(0.235573213359357), U(0.784513610477560)});
+      else if (order == 8)
+        symmetric({U(0.102799849391985), U(-1.96061023297549), U(1.93813913762276),
+                   U(-0.158240635368243), U(-1.44485223686048), U(0.253693336566229),
+                   U(0.914844246229740)});
+      else
+        throw std::invalid_argument("composition: yoshida_optimal exists for order 6 and 8");
+      break;
+    }
+
+    gamma_max = U(0);
+    for (const U g : gamma)
+      gamma_max = std::max(gamma_max, g < U(0) ? -g : g);
+  }
+
+  template <class U>
+  inline int composition<U>::order() const
+  {
+    return p;
+  }
+
+  template <class U>
+  inline size_t composition<U>::stages() const
+  {
+    return gamma.size();
+  }
+
+  template <class U>
+  inline const std::vector<U> &composition<U>::coefficients() const
+  {
+    return gamma;
+  }
+
+  // -- drivers ---------------------------------------------------------------
+
+  template <class U>
+  template <class Core>
+  inline void composition<U>::step(Core &core, const U h) const
+  {
+    for (const U g : gamma)
+      core.step(g * h);
+  }
+
+  template <class U>
+  template <class Core>
+  inline void composition<U>::step_adaptive(Core &core, U &h, const U mu, const U low_bound, const U high_bound) const
+  {
+    core.adapt_stepsize(h, mu / gamma_max, low_bound, high_bound);
+    step(core, h);
+  }
+
+  template <class U>
+  template <class Core>
+  inline U composition<U>::suggest_first_stepsize(Core &core, const U h_max, const U mu) const
+  {
+    return core.suggest_first_stepsize(h_max, mu / gamma_max);
+  }
+
+  // -- coefficients ----------------------------------------------------------
+
+  template <class U>
+  inline void composition<U>::recursive(const int target_order, const int substeps)
+  {
+    using std::pow;
+
+    gamma = {U(1)};
+
+    for (int q = 2; q < target_order; q += 2)
+    {
+      const U root = pow(U(substeps - 1), U(1) / U(q + 1));
+      const U g1 = U(1) / (U(substeps - 1) - root);
+      const U g0 = U(1) - U(substeps - 1) * g1;
+
+      std::vector<U> next;
+      next.reserve(gamma.size() * substeps);
+      for (int s = 0; s < substeps; ++s)
+      {
+        const U g = s == substeps / 2 ? g0 : g1;
+        for (const U c : gamma)
+          next.push_back(g * c);
+      }
+      gamma.swap(next);
+    }
+  }
+
+  // half = {w_1, ..., w_m} in Yoshida's numbering;
+  // yields w_m .. w_1 w_0 w_1 .. w_m with w_0 = 1 - 2 sum w_i
+  template <class U>
+  inline void composition<U>::symmetric(const std::vector<U> &half)
+  {
+    U w0 = U(1);
+    for (const U w : half)
+      w0 -= 2 * w;
+
+    gamma.assign(half.rbegin(), half.rend());
+    gamma.push_back(w0);
+    gamma.insert(gamma.end(), half.begin(), half.end());
+  }
+}
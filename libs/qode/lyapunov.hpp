@@ -0,0 +1,288 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <utility>
+#include <stdexcept>
+#include <ling.hpp>
+#include <qode1.hpp>
+
+// =============================================================================
+//  FILE: lyapunov.hpp  -  tangent vectors and Lyapunov exponents for qode1
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  qode1_lyapunov<U> is a qode1_core<U> that advances p tangent vectors with
+//  the state and accumulates the p leading Lyapunov exponents.
+//
+//
+//  Tangent map
+//  -----------
+//  The qode1 step solves M(x_n) x_{n+1} = x_n + h (A + B.x_n/2) with
+//  M(x) = I - h/2 J(x). Differentiating it with respect to x_n and using the
+//  symmetry of the quadratic terms gives the exact tangent map of the step
+//
+//      dx_{n+1} = M(x_n)^{-1} (I + h/2 J(x_{n+1})) dx_n.
+//
+//  M(x_n) is the matrix factorised by the step itself and J(x_{n+1}) is the
+//  matrix assembled at the start of the next step, so a tangent vector costs
+//  one matrix-vector product and one fb_naive substitution per step, without
+//  another factorisation or assembly. The LU factors of the previous step
+//  are kept by swapping buffers, and the tangent vectors lag one step behind
+//  the state until the next step (or synchronize()) completes them.
+//
+//
+//  Exponents
+//  ---------
+//  Every `orthonormalize_every` steps the tangent vectors are
+//  re-orthonormalised by modified Gram-Schmidt (math::remove_tangent_components)
+//  and the logarithms of their norms are accumulated, so that
+//
+//      exponents()[j] = (sum of log |v_j|) / t
+//
+//  converges to the j-th Lyapunov exponent (Benettin et al. 1980). t is the
+//  time of the last orthonormalisation: the norm growth of later tangent
+//  steps is not in the sums yet, so their time is not counted either.
+//
+//
+//  How to use
+//  ----------
+//      class Lorenz : public qode::qode1_lyapunov<double> { ... set_coef() ... };
+//
+//      Lorenz sys(3, 3);            // dimension, number of tangent vectors
+//      sys.x = {1.0, 1.0, 1.0};
+//      sys.reset_tangents();
+//      for (...) sys.step(h);
+//      sys.synchronize();
+//      auto lambda = sys.exponents();
+//
+//  step / step_adaptive are those of qode1_core; the tangent update sits in
+//  the finish_step hook, so it also runs when the system is stepped through
+//  a qode1_core<U>& (e.g. by composition). richardson_controller retracts
+//  trial steps; save_step_state / restore_step_state let it retract the
+//  tangent vectors, sums and times with x (see step_control.hpp).
+//
+//  The number of tangent vectors is at most the dimension; the constructor
+//  throws std::invalid_argument otherwise.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class qode1_lyapunov : public qode1_core<U>
+  {
+  public:
+    int orthonormalize_every = 1;
+
+    qode1_lyapunov(const size_t size, const int tangents);
+
+    // tangent vectors <- e_0 .. e_{p-1}, accumulated sums and time <- 0
+    void reset_tangents();
+
+    // completes the pending tangent step so that tangent(j) belongs to x
+    void synchronize();
+
+    // tangent state <-> saved copy, for step controllers that retract
+    // trial steps
+    void save_step_state();
+    void restore_step_state();
+
+    int tangents() const;
+    const std::vector<U> &tangent(const int j) const;
+    std::vector<U> exponents() const;
+
+  protected:
+    // completes the pending tangent step from mat == J(x_n), then steps
+    void finish_step(const U h) override;
+
+    // finish_step reads mat as J(x), which IMEX mode does not assemble
+    bool supports_imex() const override;
+
+  private:
+    int p;
+    std::vector<std::vector<U>> v;
+    std::vector<U> lu_prev, w, log_sum;
+    U h_prev = U(0);
+    U t_tangent = U(0);
+    U t_orthonormalized = U(0); // t_tangent at the last orthonormalize()
+    int steps_since = 0;
+    bool pending = false;
+
+    struct tangent_state
+    {
+      std::vector<std::vector<U>> v;
+      std::vector<U> lu_prev, log_sum;
+      U h_prev, t_tangent, t_orthonormalized;
+      int steps_since;
+      bool pending;
+    } saved;
+
+    void complete_tangent_step();
+    void orthonormalize();
+    void state_step(const U h);
+  };
+
+  // -------------------------------------------------------------------------
+  //  qode1_lyapunov<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_lyapunov<U>::qode1_lyapunov(const size_t size, const int tangents) : qode1_core<U>(size), p(tangents)
+  {
+    if (tangents < 0 || size_t(tangents) > size)
+      throw std::invalid_argument("qode1_lyapunov: the number of tangent vectors must be between 0 and the dimension");
+    v.assign(p, std::vector<U>(size, U(0)));
+    lu_prev.resize(size * size);
+    w.resize(size);
+    reset_tangents();
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::reset_tangents()
+  {
+    for (int j = 0; j < p; j++)
+    {
+      std::fill(v[j].begin(), v[j].end(), U(0));
+      v[j][j] = U(1);
+    }
+    log_sum.assign(p, U(0));
+    t_tangent = U(0);
+    t_orthonormalized = U(0);
+    steps_since = 0;
+    pending = false;
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::synchronize()
+  {
+    if (!pending)
+      return;
+
+    this->prepare_step();
+    complete_tangent_step();
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::save_step_state()
+  {
+    saved.v = v;
+    saved.lu_prev = lu_prev;
+    saved.log_sum = log_sum;
+    saved.h_prev = h_prev;
+    saved.t_tangent = t_tangent;
+    saved.t_orthonormalized = t_orthonormalized;
+    saved.steps_since = steps_since;
+    saved.pending = pending;
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::restore_step_state()
+  {
+    v = saved.v;
+    lu_prev = saved.lu_prev;
+    log_sum = saved.log_sum;
+    h_prev = saved.h_prev;
+    t_tangent = saved.t_tangent;
+    t_orthonormalized = saved.t_orthonormalized;
+    steps_since = saved.steps_since;
+    pending = saved.pending;
+  }
+
+  template <class U>
+  inline int qode1_lyapunov<U>::tangents() const
+  {
+    return p;
+  }
+
+  template <class U>
+  inline const std::vector<U> &qode1_lyapunov<U>::tangent(const int j) const
+  {
+    return v[j];
+  }
+
+  template <class U>
+  inline std::vector<U> qode1_lyapunov<U>::exponents() const
+  {
+    std::vector<U> lambda(p, U(0));
+    if (t_orthonormalized != U(0))
+      for (int j = 0; j < p; j++)
+        lambda[j] = log_sum[j] / t_orthonormalized;
+    return lambda;
+  }
+
+  // -- protected -------------------------------------------------------------
+
+  template <class U>
+  inline bool qode1_lyapunov<U>::supports_imex() const
+  {
+    return false;
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::finish_step(const U h)
+  {
+    complete_tangent_step();
+    state_step(h);
+  }
+
+  // -- private ---------------------------------------------------------------
+
+  // requires mat == J(x) assembled by prepare_step()
+  template <class U>
+  inline void qode1_lyapunov<U>::complete_tangent_step()
+  {
+    if (!pending)
+      return;
+
+    const size_t n = this->dim();
+    const U *J = this->mat.data();
+    this->stats.count(math::counter::solves, p);
+
+    for (int j = 0; j < p; j++)
+    {
+      for (size_t i = 0; i < n; i++)
+        w[i] = v[j][i] + h_prev / 2 * math::dot_product(n, J + n * i, v[j].data());
+      math::fb_naive(n, lu_prev.data(), w.data());
+      std::copy(w.begin(), w.end(), v[j].begin());
+    }
+
+    t_tangent += h_prev;
+    pending = false;
+
+    if (++steps_since >= orthonormalize_every)
+      orthonormalize();
+  }
+
+  template <class U>
+  inline void qode1_lyapunov<U>::orthonormalize()
+  {
+    using std::log;
+    using std::sqrt;
+
+    const size_t n = this->dim();
+    for (int j = 0; j < p; j++)
+    {
+      math::remove_tangent_components(n, j, v[j].data(), v);
+      const U norm = sqrt(math::dot_product(n, v[j].data(), v[j].data()));
+      log_sum[j] += log(norm);
+      for (size_t i = 0; i < n; i++)
+        v[j][i] /= norm;
+    }
+    t_orthonormalized = t_tangent;
+    steps_since = 0;
+  }
+
+  // the LU factors of M(x_n) are kept in lu_prev for the tangent step
+  template <class U>
+  inline void qode1_lyapunov<U>::state_step(const U h)
+  {
+    this->stats.count(math::counter::steps);
+    this->stats.count(math::counter::factorizations);
+    this->stats.count(math::counter::solves);
+    symmetric_update(this->dim(), h, this->mat.data(), this->vec.data(), this->x.data());
+    std::swap(this->mat, lu_prev);
+    h_prev = h;
+    pending = true;
+  }
+}
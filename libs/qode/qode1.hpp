@@ -2,7 +2,13 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <type_traits>
+#include <array>
+#include <utility>
+#include <stdexcept>
 #include <ling.hpp>
+#include <stats.hpp>
+#include <kernel_config.hpp>
 
 // =============================================================================
 //  FILE: qode1.hpp  -  Quadratic ODE integrator with stepsize control
@@ -78,6 +84,44 @@
 //        where h_mid is defined by
 //            spectral_radius * h_mid = mu.
 //
+//    * adapt_stepsize(h, mu, low_bound, high_bound)
+//
+//        Only adjusts h as step_adaptive does, without performing the step.
+//        Used by drivers that build a step from several substeps
+//        (see composition.hpp).
+//
+//
+//  Mixed precision
+//  ---------------
+//  qode1_core<U, Ufactor> with a lower-precision Ufactor (e.g.
+//  qode1_core<double, float>) assembles the system in U, factorises it in
+//  Ufactor and recovers the accuracy of U by `refinement_steps` steps of
+//  iterative refinement (math::solve_refined). For large n this halves the
+//  memory traffic of the O(n^3) factorisation.
+//
+//
+//  IMEX mode
+//  ---------
+//  set_imex(true) suits models whose stiffness sits in the constant B
+//  coefficients while the C terms are mild. The step then treats B
+//  implicitly and the quadratic terms by one predictor-corrector pass,
+//
+//      (I - h/2 B) x*      = x_n + h (A + B.x_n/2 + C.x_n.x_n),
+//      (I - h/2 B) x_{n+1} = x_n + h (A + B.x_n/2 + C.x_n.x*),
+//
+//  which is second order like the implicit step. I - h/2 B is factorised
+//  once and reused while h stays the same, so a step costs two forward and
+//  back substitutions instead of an O(n^3) factorisation; steps with a new
+//  h refactorise. B is read in the first prepare_step after set_imex(true);
+//  call linear_part_changed() if set_coef() later assigns different B
+//  coefficients. In IMEX mode the spectral radius used by the stepsize
+//  control is that of the explicit quadratic part. IMEX mode leaves mat
+//  without the B part, so integrators whose finish_step reads mat as J(x)
+//  declare it unsupported (supports_imex() == false) and set_imex(true)
+//  throws std::invalid_argument on them: ricatti_core (ricatti.hpp) and
+//  qode1_lyapunov (lyapunov.hpp). evaluate() and thus steady_state_solver
+//  stay correct in IMEX mode.
+//
 //
 //  Notes
 //  -----
@@ -86,16 +130,120 @@
 //    on moderate stepsizes and problem structure.
 //  * The Jacobian spectral radius for stepsize is estimated heuristically and
 //    is not guaranteed to be an upper or lower bound.
+//  * Derived integrators replace the update by overriding the protected
+//    virtual finish_step(h), not by hiding step / step_adaptive.
 //
 // =============================================================================
 
 namespace qode
 {
+  // ---------------------------------------------------------------------------
+  //  adapted_stepsize
+  // ---------------------------------------------------------------------------
+  //  Symmetric stepsize update used by step_adaptive: returns h_new such that
+  //  h_new * h = h_mid^2 with omega * h_mid = mu, limited to the interval
+  //  [low_bound * h, high_bound * h].
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline U adapted_stepsize(const U h, const U omega, const U mu, const U low_bound, const U high_bound)
+  {
+    using std::sqrt;
+    return h * std::max(low_bound, sqrt(mu / std::max(mu / (high_bound * high_bound), omega * h)));
+  }
+
+  // ---------------------------------------------------------------------------
+  //  symmetric_system / symmetric_update
+  // ---------------------------------------------------------------------------
+  //  symmetric_system turns mat and vec, assembled from the A/B/C
+  //  coefficients at x, into the linear system of one qode1 step:
+  //      mat <- I - h/2 mat,     x <- x + h vec.
+  //  symmetric_update additionally solves it, i.e. performs the step
+  //      x <- (I - h/2 mat)^{-1} (x + h vec)
+  //  in place. On return mat holds the LU factors of I - h/2 mat.
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  inline void symmetric_system(const size_t n, const U h, U mat[], const U vec[], U x[])
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      const size_t row_i = n * i;
+      for (size_t j = 0; j < n; j++)
+        mat[row_i + j] *= -h / 2;
+
+      mat[row_i + i] += 1;
+      x[i] += h * vec[i];
+    }
+  }
+
+  template <class U>
+  inline void symmetric_update(const size_t n, const U h, U mat[], const U vec[], U x[])
+  {
+    symmetric_system(n, h, mat, vec, x);
+    math::lu_naive(n, mat);
+    math::fb_naive(n, mat, x);
+  }
+
+  // ---------------------------------------------------------------------------
+  //  symmetric_kernel
+  // ---------------------------------------------------------------------------
+  //  The step x <- (I - h/2 mat)^{-1} (x + h vec) behind a function pointer
+  //  chosen once per dimension from math::kernel_thresholds_for<U>()
+  //  (kernel_config.hpp; tuned per host by ode_lab_autotune): up to
+  //  fixed_max a kernel with n fixed at compile time (the unrolled
+  //  math::solve_opt<n> up to n = 6, fully unrollable loops above, n <= 16),
+  //  from blocked_min symmetric_system + math::lu_blocked, and
+  //  symmetric_update in between. Unlike symmetric_update, the fixed-size
+  //  kernels do not leave the LU factors in mat.
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  using symmetric_kernel = void (*)(const size_t n, const U h, U mat[], const U vec[], U x[]);
+
+  template <size_t n, class U>
+  inline void symmetric_solve_fixed(const size_t, const U h, U mat[], const U vec[], U x[])
+  {
+    symmetric_system(n, h, mat, vec, x);
+    math::solve_opt<n>(mat, x);
+  }
+
+  template <class U>
+  inline void symmetric_solve_blocked(const size_t n, const U h, U mat[], const U vec[], U x[])
+  {
+    symmetric_system(n, h, mat, vec, x);
+    math::lu_blocked(n, mat, math::kernel_thresholds_for<U>().block);
+    math::fb_naive(n, mat, x);
+  }
+
+  namespace kernel_detail
+  {
+    template <class U, size_t... I>
+    constexpr auto fixed_kernels(std::index_sequence<I...>)
+    {
+      return std::array<symmetric_kernel<U>, sizeof...(I)>{&symmetric_solve_fixed<I + 1, U>...};
+    }
+  }
+
   template <class U>
+  inline symmetric_kernel<U> select_symmetric_kernel(const size_t n)
+  {
+    static constexpr auto fixed = kernel_detail::fixed_kernels<U>(std::make_index_sequence<math::max_fixed_kernel>{});
+    const math::kernel_thresholds &t = math::kernel_thresholds_for<U>();
+    if (n >= 1 && n <= std::min(t.fixed_max, fixed.size()))
+      return fixed[n - 1];
+    if (n >= t.blocked_min)
+      return &symmetric_solve_blocked<U>;
+    return &symmetric_update<U>;
+  }
+
+  template <class U, class Ufactor = U>
   class qode1_core
   {
   public:
     std::vector<U> x;
+    int refinement_steps = 2;
+    [[no_unique_address]] math::solver_stats<> stats;
 
     explicit qode1_core(const size_t size);
 
@@ -104,8 +252,17 @@ namespace qode
     size_t dim() const;
     void step(const U h);
     void step_adaptive(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0));
+    void adapt_stepsize(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0));
     U suggest_first_stepsize(const U h_max, const U mu);
 
+    void set_imex(const bool enabled);
+    bool imex() const;
+    void linear_part_changed();
+
+    // f(x) and, if jac is given, the Jacobian J(x) (row-major n x n) at
+    // the current state, from one assembly by set_coef()
+    void evaluate(U f[], U jac[] = nullptr);
+
   protected:
     std::vector<U> mat, vec;
 
@@ -134,130 +291,273 @@ namespace qode
     BCoefProxy b_coef(const size_t i, const size_t j);
     CCoefProxy c_coef(const size_t i, const size_t j, const size_t k);
 
+    // assembles mat = J(x) and vec = A + B.x/2 at the current state,
+    // so that f(x) = vec + mat.x/2
+    void prepare_step();
+
+    // advances x by h from the system assembled by prepare_step(); the
+    // one step hook of step / step_adaptive, overridden by integrators with
+    // another update (ricatti_core, qode1_lyapunov), so that drivers
+    // holding a qode1_core& run their step
+    virtual void finish_step(const U h);
+
+    // false for derived integrators that need mat == J(x) in finish_step
+    virtual bool supports_imex() const;
+
   private:
     size_t n;
+    symmetric_kernel<U> kernel;
+    std::vector<Ufactor> lu, correction;
+    std::vector<U> rhs;
 
-    void prepare_step();
-    void finish_step(const U h);
+    // IMEX mode: B and the LU factors of I - h/2 B for h == linear_h
+    bool imex_mode = false, linear_assembled = false, linear_factored = false;
+    U linear_h = U(0);
+    std::vector<U> linear, linear_lu, predictor;
+
+    void imex_step(const U h);
     U jacobian_spectral_radius();
   };
 
   // -------------------------------------------------------------------------
-  //  qode1_core<U> implementation
+  //  qode1_core<U, Ufactor> implementation
   // -------------------------------------------------------------------------
 
   // -- public API ------------------------------------------------------------
 
-  template <class U>
-  inline qode1_core<U>::qode1_core(const size_t size) : n(size)
+  template <class U, class Ufactor>
+  inline qode1_core<U, Ufactor>::qode1_core(const size_t size) : n(size), kernel(select_symmetric_kernel<U>(size))
   {
     vec.resize(n, U(0));
     mat.resize(n * n, U(0));
+
+    if constexpr (!std::is_same_v<U, Ufactor>)
+    {
+      lu.resize(n * n);
+      correction.resize(n);
+      rhs.resize(n);
+    }
   }
 
-  template <class U>
-  inline size_t qode1_core<U>::dim() const
+  template <class U, class Ufactor>
+  inline size_t qode1_core<U, Ufactor>::dim() const
   {
     return n;
   }
 
-  template <class U>
-  inline void qode1_core<U>::step(const U h)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::step(const U h)
   {
     prepare_step();
     finish_step(h);
   }
 
-  template <class U>
-  inline void qode1_core<U>::step_adaptive(U &h, const U mu, const U low_bound, const U high_bound)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::step_adaptive(U &h, const U mu, const U low_bound, const U high_bound)
+  {
+    adapt_stepsize(h, mu, low_bound, high_bound);
+    finish_step(h);
+  }
+
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::adapt_stepsize(U &h, const U mu, const U low_bound, const U high_bound)
   {
     prepare_step();
     U omega = jacobian_spectral_radius();
-    h *= std::max(low_bound, std::sqrt(mu / std::max(mu / (high_bound * high_bound), omega * h)));
-    finish_step(h);
+    h = adapted_stepsize(h, omega, mu, low_bound, high_bound);
   }
 
-  template <class U>
-  inline U qode1_core<U>::suggest_first_stepsize(const U h_max, const U mu)
+  template <class U, class Ufactor>
+  inline U qode1_core<U, Ufactor>::suggest_first_stepsize(const U h_max, const U mu)
   {
     prepare_step();
     U omega = jacobian_spectral_radius();
     return mu / std::max(mu / h_max, omega);
   }
 
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::evaluate(U f[], U jac[])
+  {
+    prepare_step();
+    stats.count(math::counter::rhs_evaluations);
+
+    // in IMEX mode mat holds only the C part, B is kept in `linear`
+    for (size_t i = 0; i < n; i++)
+    {
+      f[i] = vec[i] + math::dot_product(n, &mat[n * i], x.data()) / 2;
+      if (imex_mode)
+        f[i] += math::dot_product(n, &linear[n * i], x.data()) / 2;
+    }
+
+    if (jac)
+    {
+      std::copy(mat.begin(), mat.end(), jac);
+      if (imex_mode)
+        for (size_t k = 0; k < n * n; k++)
+          jac[k] += linear[k];
+    }
+  }
+
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::set_imex(const bool enabled)
+  {
+    if (enabled && !supports_imex())
+      throw std::invalid_argument("qode1_core: IMEX mode is not supported by this integrator");
+    imex_mode = enabled;
+    if (enabled)
+    {
+      linear.resize(n * n);
+      linear_lu.resize(n * n);
+      predictor.resize(n);
+    }
+    linear_part_changed();
+  }
+
+  template <class U, class Ufactor>
+  inline bool qode1_core<U, Ufactor>::imex() const
+  {
+    return imex_mode;
+  }
+
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::linear_part_changed()
+  {
+    std::fill(linear.begin(), linear.end(), U(0));
+    linear_assembled = false;
+    linear_factored = false;
+  }
+
   // -- proxies ---------------------------------------------------------------
 
-  template <class U>
-  inline void qode1_core<U>::ACoefProxy::operator=(U value)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::ACoefProxy::operator=(U value)
   {
     self.vec[i] += value;
   }
 
-  template <class U>
-  inline void qode1_core<U>::BCoefProxy::operator=(U value)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::BCoefProxy::operator=(U value)
   {
-    self.mat[self.n * i + j] += value;
+    if (!self.imex_mode)
+      self.mat[self.n * i + j] += value;
+    else if (!self.linear_assembled)
+      self.linear[self.n * i + j] += value;
     self.vec[i] += value * self.x[j] / 2;
   }
 
-  template <class U>
-  inline void qode1_core<U>::CCoefProxy::operator=(U value)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::CCoefProxy::operator=(U value)
   {
     self.mat[self.n * i + j] += value * self.x[k];
     self.mat[self.n * i + k] += value * self.x[j];
   }
 
-  template <class U>
-  inline typename qode1_core<U>::ACoefProxy
-  qode1_core<U>::a_coef(const size_t i)
+  template <class U, class Ufactor>
+  inline typename qode1_core<U, Ufactor>::ACoefProxy
+  qode1_core<U, Ufactor>::a_coef(const size_t i)
   {
     return ACoefProxy{*this, i};
   }
 
-  template <class U>
-  inline typename qode1_core<U>::BCoefProxy
-  qode1_core<U>::b_coef(const size_t i, const size_t j)
+  template <class U, class Ufactor>
+  inline typename qode1_core<U, Ufactor>::BCoefProxy
+  qode1_core<U, Ufactor>::b_coef(const size_t i, const size_t j)
   {
     return BCoefProxy{*this, i, j};
   }
 
-  template <class U>
-  inline typename qode1_core<U>::CCoefProxy
-  qode1_core<U>::c_coef(const size_t i, const size_t j, const size_t k)
+  template <class U, class Ufactor>
+  inline typename qode1_core<U, Ufactor>::CCoefProxy
+  qode1_core<U, Ufactor>::c_coef(const size_t i, const size_t j, const size_t k)
   {
     return CCoefProxy{*this, i, j, k};
   }
 
+  // -- protected -------------------------------------------------------------
+
+  template <class U, class Ufactor>
+  inline bool qode1_core<U, Ufactor>::supports_imex() const
+  {
+    return true;
+  }
+
   // -- private ---------------------------------------------------------------
 
-  template <class U>
-  inline U qode1_core<U>::jacobian_spectral_radius()
+  template <class U, class Ufactor>
+  inline U qode1_core<U, Ufactor>::jacobian_spectral_radius()
   {
+    auto timer = stats.time(math::phase::spectral_estimate);
     return math::spectral_radius_estimate(n, mat.data());
   }
 
-  template <class U>
-  inline void qode1_core<U>::prepare_step()
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::prepare_step()
   {
+    auto timer = stats.time(math::phase::assemble);
+    stats.count(math::counter::assemblies);
     std::fill(vec.begin(), vec.end(), U(0));
     std::fill(mat.begin(), mat.end(), U(0));
     set_coef();
+    linear_assembled = imex_mode;
   }
 
-  template <class U>
-  inline void qode1_core<U>::finish_step(const U h)
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::finish_step(const U h)
   {
-    for (size_t i = 0; i < n; i++)
+    auto timer = stats.time(math::phase::linear_solve);
+    stats.count(math::counter::steps);
+
+    if (imex_mode)
     {
-      const size_t row_i = n * i;
-      for (size_t j = 0; j < n; j++)
-        mat[row_i + j] *= -h / 2;
+      imex_step(h);
+      return;
+    }
 
-      mat[row_i + i] += 1;
-      x[i] += h * vec[i];
+    stats.count(math::counter::factorizations);
+    if constexpr (std::is_same_v<U, Ufactor>)
+    {
+      stats.count(math::counter::solves);
+      kernel(n, h, mat.data(), vec.data(), x.data());
+    }
+    else
+    {
+      stats.count(math::counter::solves, refinement_steps + 1);
+      symmetric_system(n, h, mat.data(), vec.data(), x.data());
+      math::solve_refined(n, mat.data(), x.data(), lu.data(), correction.data(), rhs.data(), refinement_steps);
     }
+  }
 
-    math::lu_naive(n, mat.data());
-    math::fb_naive(n, mat.data(), x.data());
+  template <class U, class Ufactor>
+  inline void qode1_core<U, Ufactor>::imex_step(const U h)
+  {
+    if (!linear_factored || h != linear_h)
+    {
+      stats.count(math::counter::factorizations);
+      std::copy(linear.begin(), linear.end(), linear_lu.begin());
+      for (size_t i = 0; i < n; i++)
+      {
+        for (size_t j = 0; j < n; j++)
+          linear_lu[n * i + j] *= -h / 2;
+        linear_lu[n * i + i] += 1;
+      }
+      const math::kernel_thresholds &t = math::kernel_thresholds_for<U>();
+      if (n >= t.blocked_min)
+        math::lu_blocked(n, linear_lu.data(), t.block);
+      else
+        math::lu_naive(n, linear_lu.data());
+      linear_h = h;
+      linear_factored = true;
+    }
+
+    // mat holds the Jacobian of the C terms at x_n, so that
+    // C.x_n.y = mat.y/2 for the symmetrised quadratic form
+    stats.count(math::counter::solves, 2);
+    for (size_t i = 0; i < n; i++)
+      predictor[i] = x[i] + h * (vec[i] + math::dot_product(n, &mat[n * i], x.data()) / 2);
+    math::fb_naive(n, linear_lu.data(), predictor.data());
+
+    for (size_t i = 0; i < n; i++)
+      x[i] += h * (vec[i] + math::dot_product(n, &mat[n * i], predictor.data()) / 2);
+    math::fb_naive(n, linear_lu.data(), x.data());
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,510 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <stdexcept>
+#include <qode1.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// =============================================================================
+//  FILE: qode1_file.hpp  -  model files for large quadratic networks
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  Networks with 10^4 - 10^6 coefficients are better stored in a file than
+//  written out in a set_coef() override. This file defines
+//
+//    * qode1_coefficients<U>  the A/B/C terms as index/value triplet lists,
+//                             built in memory with a_coef/b_coef/c_coef
+//    * qode1_file<U>          a model file opened read-only; binary files are
+//                             memory-mapped and used in place (zero copy),
+//                             text files are parsed into qode1_coefficients
+//    * qode1_mapped<U>        a qode1_core whose set_coef() walks the triplets
+//                             of a shared qode1_file
+//
+//  and write_binary / write_text to produce the files.
+//
+//
+//  Binary format (native byte order, version 1)
+//  --------------------------------------------
+//      header    "QODE1BIN", uint32 version, uint32 sizeof(U),
+//                uint64 n, n_a, n_b, n_c                         (48 bytes)
+//      indices   uint32 a[n_a], b[2 n_b], c[3 n_c]  (i / i,j / i,j,k)
+//      padding   to a multiple of 16 bytes
+//      values    U a[n_a], b[n_b], c[n_c]
+//
+//  Text format
+//  -----------
+//      qode1 <n>
+//      A <i> <value>
+//      B <i> <j> <value>
+//      C <i> <j> <k> <value>
+//
+//  one term per line, '#' starts a comment line. Repeated terms add up as
+//  in set_coef(). Values are written with max_digits10, so a text round
+//  trip is exact.
+//
+//
+//  How to use
+//  ----------
+//      auto file = qode::qode1_file<double>::open("network.q1b");
+//      qode::qode1_mapped<double> run(file);
+//      run.x.assign(run.dim(), 1.0);
+//      run.step(h);
+//
+//  Opening validates all indices against n once, in O(number of terms);
+//  malformed files throw std::runtime_error. Indices are stored as uint32,
+//  so n is at most 2^32 - 1; qode1_coefficients throws std::out_of_range
+//  for n or indices beyond that or beyond its dimension.
+//
+// =============================================================================
+
+namespace qode
+{
+  // read-only view of the triplet lists of a model
+  template <class U>
+  struct qode1_terms
+  {
+    size_t n = 0;
+    std::span<const uint32_t> a_index, b_index, c_index;
+    std::span<const U> a_value, b_value, c_value;
+  };
+
+  template <class U>
+  class qode1_coefficients
+  {
+  public:
+    explicit qode1_coefficients(const size_t size);
+
+    size_t dim() const;
+
+    void a_coef(const size_t i, const U value);
+    void b_coef(const size_t i, const size_t j, const U value);
+    void c_coef(const size_t i, const size_t j, const size_t k, const U value);
+
+    qode1_terms<U> terms() const;
+
+  private:
+    size_t n;
+
+    uint32_t index(const size_t i) const;
+    std::vector<uint32_t> a_index, b_index, c_index;
+    std::vector<U> a_value, b_value, c_value;
+  };
+
+  template <class U>
+  class qode1_file
+  {
+  public:
+    // detects the format from the first bytes of the file
+    static std::shared_ptr<const qode1_file> open(const std::string &path);
+
+    ~qode1_file();
+    qode1_file(const qode1_file &) = delete;
+    qode1_file &operator=(const qode1_file &) = delete;
+
+    size_t dim() const;
+    const qode1_terms<U> &terms() const;
+    bool mapped() const;
+
+  private:
+    qode1_file() = default;
+
+    void open_binary(const std::string &path);
+    void open_text(std::istream &in);
+    void validate() const;
+
+    qode1_terms<U> view;
+    const void *map_data = nullptr;
+    size_t map_size = 0;
+    std::vector<long double> owned_bytes; // binary fallback without mmap
+    std::unique_ptr<qode1_coefficients<U>> owned_terms;
+  };
+
+  template <class U>
+  void write_binary(const std::string &path, const qode1_terms<U> &terms);
+
+  template <class U>
+  void write_text(const std::string &path, const qode1_terms<U> &terms);
+
+  template <class U, class Ufactor = U>
+  class qode1_mapped : public qode1_core<U, Ufactor>
+  {
+  public:
+    explicit qode1_mapped(std::shared_ptr<const qode1_file<U>> model_file);
+
+    void set_coef() override;
+
+  private:
+    std::shared_ptr<const qode1_file<U>> file;
+  };
+
+  namespace file_detail
+  {
+    inline constexpr char magic[8] = {'Q', 'O', 'D', 'E', '1', 'B', 'I', 'N'};
+    inline constexpr uint32_t version = 1;
+
+    struct header
+    {
+      char magic[8];
+      uint32_t version, value_size;
+      uint64_t n, n_a, n_b, n_c;
+    };
+
+    static_assert(sizeof(header) == 48);
+
+    inline constexpr uint64_t max_dim = std::numeric_limits<uint32_t>::max();
+
+    // no overflow for counts bounded by the file size (see open_binary)
+    inline size_t index_bytes(const uint64_t n_a, const uint64_t n_b, const uint64_t n_c)
+    {
+      const size_t bytes = sizeof(uint32_t) * (n_a + 2 * n_b + 3 * n_c);
+      return (bytes + 15) / 16 * 16;
+    }
+
+    [[noreturn]] inline void fail(const std::string &path, const std::string &what)
+    {
+      throw std::runtime_error("qode1_file: " + path + ": " + what);
+    }
+  }
+
+  // -------------------------------------------------------------------------
+  //  qode1_coefficients<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_coefficients<U>::qode1_coefficients(const size_t size) : n(size)
+  {
+    if (n > file_detail::max_dim)
+      throw std::out_of_range("qode1_coefficients: n = " + std::to_string(n) + " exceeds the 32-bit index range");
+  }
+
+  template <class U>
+  inline size_t qode1_coefficients<U>::dim() const
+  {
+    return n;
+  }
+
+  template <class U>
+  inline uint32_t qode1_coefficients<U>::index(const size_t i) const
+  {
+    if (i >= n)
+      throw std::out_of_range("qode1_coefficients: index " + std::to_string(i) + " out of range for n = " +
+                              std::to_string(n));
+    return uint32_t(i);
+  }
+
+  template <class U>
+  inline void qode1_coefficients<U>::a_coef(const size_t i, const U value)
+  {
+    a_index.push_back(index(i));
+    a_value.push_back(value);
+  }
+
+  template <class U>
+  inline void qode1_coefficients<U>::b_coef(const size_t i, const size_t j, const U value)
+  {
+    b_index.insert(b_index.end(), {index(i), index(j)});
+    b_value.push_back(value);
+  }
+
+  template <class U>
+  inline void qode1_coefficients<U>::c_coef(const size_t i, const size_t j, const size_t k, const U value)
+  {
+    c_index.insert(c_index.end(), {index(i), index(j), index(k)});
+    c_value.push_back(value);
+  }
+
+  template <class U>
+  inline qode1_terms<U> qode1_coefficients<U>::terms() const
+  {
+    return {n, a_index, b_index, c_index, a_value, b_value, c_value};
+  }
+
+  // -------------------------------------------------------------------------
+  //  qode1_file<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline std::shared_ptr<const qode1_file<U>> qode1_file<U>::open(const std::string &path)
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+      file_detail::fail(path, "cannot open");
+
+    char first[8] = {};
+    in.read(first, sizeof(first));
+
+    const bool binary = in.gcount() == sizeof(first) && std::memcmp(first, file_detail::magic, sizeof(first)) == 0;
+
+    std::shared_ptr<qode1_file> f(new qode1_file());
+    if (binary)
+    {
+      in.close();
+      f->open_binary(path);
+    }
+
+    try
+    {
+      if (!binary)
+      {
+        in.clear();
+        in.seekg(0);
+        f->open_text(in);
+      }
+      f->validate();
+    }
+    catch (const std::runtime_error &e)
+    {
+      file_detail::fail(path, e.what());
+    }
+    catch (const std::out_of_range &e) // from qode1_coefficients
+    {
+      file_detail::fail(path, e.what());
+    }
+    return f;
+  }
+
+  template <class U>
+  inline qode1_file<U>::~qode1_file()
+  {
+#if defined(__unix__) || defined(__APPLE__)
+    if (map_data)
+      munmap(const_cast<void *>(map_data), map_size);
+#endif
+  }
+
+  template <class U>
+  inline size_t qode1_file<U>::dim() const
+  {
+    return view.n;
+  }
+
+  template <class U>
+  inline const qode1_terms<U> &qode1_file<U>::terms() const
+  {
+    return view;
+  }
+
+  template <class U>
+  inline bool qode1_file<U>::mapped() const
+  {
+    return map_data != nullptr;
+  }
+
+  template <class U>
+  inline void qode1_file<U>::open_binary(const std::string &path)
+  {
+    using file_detail::fail;
+    const char *bytes = nullptr;
+
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      fail(path, "cannot open");
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      fail(path, "cannot stat");
+    }
+    map_size = size_t(st.st_size);
+    void *p = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      fail(path, "mmap failed");
+    map_data = p;
+    bytes = static_cast<const char *>(p);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+      fail(path, "cannot open");
+    map_size = size_t(in.tellg());
+    owned_bytes.resize((map_size + sizeof(long double) - 1) / sizeof(long double));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(owned_bytes.data()), std::streamsize(map_size));
+    bytes = reinterpret_cast<const char *>(owned_bytes.data());
+#endif
+
+    file_detail::header h;
+    if (map_size < sizeof(h))
+      fail(path, "truncated header");
+    std::memcpy(&h, bytes, sizeof(h));
+    if (h.version != file_detail::version)
+      fail(path, "unsupported version " + std::to_string(h.version));
+    if (h.value_size != sizeof(U))
+      fail(path, "stored with " + std::to_string(h.value_size) + "-byte values, expected " + std::to_string(sizeof(U)));
+
+    // every term takes more than one byte, so counts above the file size
+    // are malformed; bounding them first keeps the byte counts below from
+    // wrapping around
+    if (h.n_a > map_size || h.n_b > map_size || h.n_c > map_size)
+      fail(path, "term counts exceed the file size");
+    if (h.n > file_detail::max_dim)
+      fail(path, "n = " + std::to_string(h.n) + " exceeds the 32-bit index range");
+
+    const size_t index_bytes = file_detail::index_bytes(h.n_a, h.n_b, h.n_c);
+    if (map_size != sizeof(h) + index_bytes + sizeof(U) * (h.n_a + h.n_b + h.n_c))
+      fail(path, "size does not match the header");
+
+    const uint32_t *index = reinterpret_cast<const uint32_t *>(bytes + sizeof(h));
+    const U *value = reinterpret_cast<const U *>(bytes + sizeof(h) + index_bytes);
+
+    view.n = size_t(h.n);
+    view.a_index = {index, size_t(h.n_a)};
+    view.b_index = {index + h.n_a, size_t(2 * h.n_b)};
+    view.c_index = {index + h.n_a + 2 * h.n_b, size_t(3 * h.n_c)};
+    view.a_value = {value, size_t(h.n_a)};
+    view.b_value = {value + h.n_a, size_t(h.n_b)};
+    view.c_value = {value + h.n_a + h.n_b, size_t(h.n_c)};
+  }
+
+  template <class U>
+  inline void qode1_file<U>::open_text(std::istream &in)
+  {
+    std::string line, tag;
+    size_t n = 0;
+    while (std::getline(in, line))
+    {
+      if (line.empty() || line[0] == '#')
+        continue;
+      std::istringstream fields(line);
+      if (!(fields >> tag >> n) || tag != "qode1")
+        throw std::runtime_error("expected 'qode1 <n>' in the first line");
+      break;
+    }
+    owned_terms = std::make_unique<qode1_coefficients<U>>(n);
+
+    size_t i, j, k;
+    U value;
+    while (std::getline(in, line))
+    {
+      if (line.empty() || line[0] == '#')
+        continue;
+      std::istringstream fields(line);
+      fields >> tag;
+      if (tag == "A" && fields >> i >> value)
+        owned_terms->a_coef(i, value);
+      else if (tag == "B" && fields >> i >> j >> value)
+        owned_terms->b_coef(i, j, value);
+      else if (tag == "C" && fields >> i >> j >> k >> value)
+        owned_terms->c_coef(i, j, k, value);
+      else
+        throw std::runtime_error("malformed line '" + line + "'");
+    }
+    view = owned_terms->terms();
+  }
+
+  template <class U>
+  inline void qode1_file<U>::validate() const
+  {
+    uint32_t largest = 0;
+    for (const auto *index : {&view.a_index, &view.b_index, &view.c_index})
+      for (const uint32_t i : *index)
+        largest = std::max(largest, i);
+    if (view.n == 0)
+      throw std::runtime_error("empty model (n = 0)");
+    if (largest >= view.n)
+      throw std::runtime_error("index " + std::to_string(largest) + " out of range for n = " + std::to_string(view.n));
+  }
+
+  // -------------------------------------------------------------------------
+  //  writers
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline void write_binary(const std::string &path, const qode1_terms<U> &terms)
+  {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+      file_detail::fail(path, "cannot create");
+
+    file_detail::header h;
+    std::memcpy(h.magic, file_detail::magic, sizeof(h.magic));
+    h.version = file_detail::version;
+    h.value_size = sizeof(U);
+    h.n = terms.n;
+    h.n_a = terms.a_value.size();
+    h.n_b = terms.b_value.size();
+    h.n_c = terms.c_value.size();
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+
+    auto write = [&](const auto &span)
+    {
+      out.write(reinterpret_cast<const char *>(span.data()), std::streamsize(span.size_bytes()));
+    };
+    write(terms.a_index);
+    write(terms.b_index);
+    write(terms.c_index);
+
+    const size_t padding = file_detail::index_bytes(h.n_a, h.n_b, h.n_c) -
+                           sizeof(uint32_t) * (h.n_a + 2 * h.n_b + 3 * h.n_c);
+    const char zeros[16] = {};
+    out.write(zeros, std::streamsize(padding));
+
+    write(terms.a_value);
+    write(terms.b_value);
+    write(terms.c_value);
+
+    if (!out)
+      file_detail::fail(path, "write failed");
+  }
+
+  template <class U>
+  inline void write_text(const std::string &path, const qode1_terms<U> &terms)
+  {
+    std::ofstream out(path);
+    if (!out)
+      file_detail::fail(path, "cannot create");
+    out.precision(std::numeric_limits<U>::max_digits10);
+
+    out << "qode1 " << terms.n << "\n";
+    for (size_t t = 0; t < terms.a_value.size(); t++)
+      out << "A " << terms.a_index[t] << ' ' << terms.a_value[t] << '\n';
+    for (size_t t = 0; t < terms.b_value.size(); t++)
+      out << "B " << terms.b_index[2 * t] << ' ' << terms.b_index[2 * t + 1] << ' ' << terms.b_value[t] << '\n';
+    for (size_t t = 0; t < terms.c_value.size(); t++)
+      out << "C " << terms.c_index[3 * t] << ' ' << terms.c_index[3 * t + 1] << ' ' << terms.c_index[3 * t + 2]
+          << ' ' << terms.c_value[t] << '\n';
+
+    if (!out)
+      file_detail::fail(path, "write failed");
+  }
+
+  // -------------------------------------------------------------------------
+  //  qode1_mapped<U, Ufactor> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U, class Ufactor>
+  inline qode1_mapped<U, Ufactor>::qode1_mapped(std::shared_ptr<const qode1_file<U>> model_file)
+      : qode1_core<U, Ufactor>(model_file->dim()), file(std::move(model_file))
+  {
+    this->x.assign(this->dim(), U(0));
+  }
+
+  template <class U, class Ufactor>
+  inline void qode1_mapped<U, Ufactor>::set_coef()
+  {
+    const qode1_terms<U> &t = file->terms();
+
+    for (size_t m = 0; m < t.a_value.size(); m++)
+      this->a_coef(t.a_index[m]) = t.a_value[m];
+    for (size_t m = 0; m < t.b_value.size(); m++)
+      this->b_coef(t.b_index[2 * m], t.b_index[2 * m + 1]) = t.b_value[m];
+    for (size_t m = 0; m < t.c_value.size(); m++)
+      this->c_coef(t.c_index[3 * m], t.c_index[3 * m + 1], t.c_index[3 * m + 2]) = t.c_value[m];
+  }
+}
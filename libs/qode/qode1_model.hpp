@@ -0,0 +1,338 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <ling.hpp>
+#include <qode1.hpp>
+
+// =============================================================================
+//  FILE: qode1_model.hpp  -  shared coefficient structure for parameter sweeps
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  qode1_core<U> keeps the model, the workspace and the state in one object.
+//  For parameter sweeps this file splits them:
+//
+//    * qode1_model<U> holds the coefficient structure of the quadratic system
+//
+//          \dot{x}_i = A_i
+//                      + sum_j     B_{i,j} x_j
+//                      + sum_{j,k} C_{i,j,k} x_j x_k,
+//
+//      where every coefficient is either a constant or scale * theta[p]
+//      for a parameter index p. It is built once and is read-only afterwards,
+//      so one instance can be shared by any number of threads.
+//
+//    * qode1_instance<U> holds only the state `x`, the parameter vector
+//      `theta` and a shared pointer to the model. The assembly matrix lives
+//      in a thread-local workspace, so it is not replicated per trajectory.
+//
+//
+//  How to use
+//  ----------
+//      auto model = std::make_shared<qode::qode1_model<double>>(2, 4);
+//      model->b_param(0, 0, 0);
+//      model->b_param(1, 1, 1);
+//      model->c_param(0, 0, 1, 2);
+//      model->c_param(1, 0, 1, 3);
+//
+//      qode::qode1_instance<double> run(model);
+//      run.theta = {2.0 / 3.0, -1.0, -4.0 / 3.0, 1.0};
+//      run.x = {1.0, 1.0};
+//      run.step_adaptive(h, mu);
+//
+//  Swapping parameters between runs is an assignment to `theta`.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class qode1_model
+  {
+  public:
+    qode1_model(const size_t size, const size_t n_params);
+
+    size_t dim() const;
+    size_t params() const;
+
+    void a_coef(const size_t i, const U value);
+    void b_coef(const size_t i, const size_t j, const U value);
+    void c_coef(const size_t i, const size_t j, const size_t k, const U value);
+
+    void a_param(const size_t i, const size_t p, const U scale = U(1));
+    void b_param(const size_t i, const size_t j, const size_t p, const U scale = U(1));
+    void c_param(const size_t i, const size_t j, const size_t k, const size_t p, const U scale = U(1));
+
+    // theta_ext[0] == 1 and theta_ext[1 + p] == theta[p]
+    void assemble(const U theta_ext[], const U x[], U mat[], U vec[]) const;
+
+    // adds to g[params() * i + p] the derivative of h * f_i with respect to
+    // theta[p] in the symmetric form of the qode1 step from x0 to x1
+    void parameter_derivatives(const U h, const U x0[], const U x1[], U g[]) const;
+
+    // adds G^T mu to grad (one entry per parameter), G as above
+    void parameter_vjp(const U h, const U x0[], const U x1[], const U mu[], U grad[]) const;
+
+  private:
+    struct term
+    {
+      uint32_t i, j, k, p;
+      U scale;
+    };
+
+    size_t n, n_par;
+    std::vector<term> a_terms, b_terms, c_terms;
+  };
+
+  template <class U>
+  class qode1_instance
+  {
+  public:
+    std::vector<U> x, theta;
+    [[no_unique_address]] math::solver_stats<> stats;
+
+    explicit qode1_instance(std::shared_ptr<const qode1_model<U>> model);
+
+    size_t dim() const;
+    void step(const U h);
+    void step_adaptive(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0));
+    void adapt_stepsize(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0));
+    U suggest_first_stepsize(const U h_max, const U mu);
+
+  protected:
+    std::shared_ptr<const qode1_model<U>> model;
+
+    struct workspace
+    {
+      std::vector<U> mat, vec, theta_ext;
+    };
+
+    // the two step hooks of step / step_adaptive / adapt_stepsize:
+    // assembly at the current x and theta, and the update of x from it;
+    // overridden by integrators that carry more state (qode1_sensitivity),
+    // so that drivers holding a qode1_instance& run their step
+    virtual workspace &prepare_step();
+    virtual void solve_step(workspace &ws, const U h);
+
+  private:
+    symmetric_kernel<U> kernel;
+
+    U spectral_radius(const workspace &ws);
+  };
+
+  // -------------------------------------------------------------------------
+  //  qode1_model<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_model<U>::qode1_model(const size_t size, const size_t n_params) : n(size), n_par(n_params)
+  {
+  }
+
+  template <class U>
+  inline size_t qode1_model<U>::dim() const
+  {
+    return n;
+  }
+
+  template <class U>
+  inline size_t qode1_model<U>::params() const
+  {
+    return n_par;
+  }
+
+  // -- building --------------------------------------------------------------
+
+  template <class U>
+  inline void qode1_model<U>::a_coef(const size_t i, const U value)
+  {
+    a_terms.push_back({uint32_t(i), 0, 0, 0, value});
+  }
+
+  template <class U>
+  inline void qode1_model<U>::b_coef(const size_t i, const size_t j, const U value)
+  {
+    b_terms.push_back({uint32_t(i), uint32_t(j), 0, 0, value});
+  }
+
+  template <class U>
+  inline void qode1_model<U>::c_coef(const size_t i, const size_t j, const size_t k, const U value)
+  {
+    c_terms.push_back({uint32_t(i), uint32_t(j), uint32_t(k), 0, value});
+  }
+
+  template <class U>
+  inline void qode1_model<U>::a_param(const size_t i, const size_t p, const U scale)
+  {
+    a_terms.push_back({uint32_t(i), 0, 0, uint32_t(p + 1), scale});
+  }
+
+  template <class U>
+  inline void qode1_model<U>::b_param(const size_t i, const size_t j, const size_t p, const U scale)
+  {
+    b_terms.push_back({uint32_t(i), uint32_t(j), 0, uint32_t(p + 1), scale});
+  }
+
+  template <class U>
+  inline void qode1_model<U>::c_param(const size_t i, const size_t j, const size_t k, const size_t p, const U scale)
+  {
+    c_terms.push_back({uint32_t(i), uint32_t(j), uint32_t(k), uint32_t(p + 1), scale});
+  }
+
+  // -- assembly --------------------------------------------------------------
+  //  Same contributions as the proxies of qode1_core.
+
+  template <class U>
+  inline void qode1_model<U>::assemble(const U theta_ext[], const U x[], U mat[], U vec[]) const
+  {
+    std::fill(vec, vec + n, U(0));
+    std::fill(mat, mat + n * n, U(0));
+
+    for (const term &t : a_terms)
+      vec[t.i] += t.scale * theta_ext[t.p];
+
+    for (const term &t : b_terms)
+    {
+      const U value = t.scale * theta_ext[t.p];
+      mat[n * t.i + t.j] += value;
+      vec[t.i] += value * x[t.j] / 2;
+    }
+
+    for (const term &t : c_terms)
+    {
+      const U value = t.scale * theta_ext[t.p];
+      mat[n * t.i + t.j] += value * x[t.k];
+      mat[n * t.i + t.k] += value * x[t.j];
+    }
+  }
+
+  //  The qode1 step solves x1 - x0 = h (A + B.(x0 + x1)/2 + C(x0, x1)) with
+  //  C(x0, x1)_i = sum c (x0_j x1_k + x0_k x1_j) / 2, so a parameter term
+  //  contributes its coefficient times the same symmetric factor.
+
+  template <class U>
+  inline void qode1_model<U>::parameter_derivatives(const U h, const U x0[], const U x1[], U g[]) const
+  {
+    const size_t m = n_par;
+
+    for (const term &t : a_terms)
+      if (t.p > 0)
+        g[m * t.i + t.p - 1] += h * t.scale;
+
+    for (const term &t : b_terms)
+      if (t.p > 0)
+        g[m * t.i + t.p - 1] += h * t.scale * (x0[t.j] + x1[t.j]) / 2;
+
+    for (const term &t : c_terms)
+      if (t.p > 0)
+        g[m * t.i + t.p - 1] += h * t.scale * (x0[t.j] * x1[t.k] + x0[t.k] * x1[t.j]) / 2;
+  }
+
+  template <class U>
+  inline void qode1_model<U>::parameter_vjp(const U h, const U x0[], const U x1[], const U mu[], U grad[]) const
+  {
+    for (const term &t : a_terms)
+      if (t.p > 0)
+        grad[t.p - 1] += mu[t.i] * h * t.scale;
+
+    for (const term &t : b_terms)
+      if (t.p > 0)
+        grad[t.p - 1] += mu[t.i] * h * t.scale * (x0[t.j] + x1[t.j]) / 2;
+
+    for (const term &t : c_terms)
+      if (t.p > 0)
+        grad[t.p - 1] += mu[t.i] * h * t.scale * (x0[t.j] * x1[t.k] + x0[t.k] * x1[t.j]) / 2;
+  }
+
+  // -------------------------------------------------------------------------
+  //  qode1_instance<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_instance<U>::qode1_instance(std::shared_ptr<const qode1_model<U>> model)
+      : model(std::move(model)), kernel(select_symmetric_kernel<U>(this->model->dim()))
+  {
+    x.resize(this->model->dim(), U(0));
+    theta.resize(this->model->params(), U(0));
+  }
+
+  template <class U>
+  inline size_t qode1_instance<U>::dim() const
+  {
+    return model->dim();
+  }
+
+  template <class U>
+  inline void qode1_instance<U>::step(const U h)
+  {
+    solve_step(prepare_step(), h);
+  }
+
+  template <class U>
+  inline void qode1_instance<U>::step_adaptive(U &h, const U mu, const U low_bound, const U high_bound)
+  {
+    workspace &ws = prepare_step();
+    U omega = spectral_radius(ws);
+    h = adapted_stepsize(h, omega, mu, low_bound, high_bound);
+    solve_step(ws, h);
+  }
+
+  template <class U>
+  inline void qode1_instance<U>::adapt_stepsize(U &h, const U mu, const U low_bound, const U high_bound)
+  {
+    workspace &ws = prepare_step();
+    U omega = spectral_radius(ws);
+    h = adapted_stepsize(h, omega, mu, low_bound, high_bound);
+  }
+
+  template <class U>
+  inline U qode1_instance<U>::suggest_first_stepsize(const U h_max, const U mu)
+  {
+    workspace &ws = prepare_step();
+    U omega = spectral_radius(ws);
+    return mu / std::max(mu / h_max, omega);
+  }
+
+  // -- protected -------------------------------------------------------------
+
+  template <class U>
+  inline typename qode1_instance<U>::workspace &qode1_instance<U>::prepare_step()
+  {
+    auto timer = stats.time(math::phase::assemble);
+    stats.count(math::counter::assemblies);
+    thread_local workspace ws;
+
+    const size_t n = dim();
+    ws.mat.resize(n * n);
+    ws.vec.resize(n);
+    ws.theta_ext.resize(theta.size() + 1);
+
+    ws.theta_ext[0] = U(1);
+    std::copy(theta.begin(), theta.end(), ws.theta_ext.begin() + 1);
+
+    model->assemble(ws.theta_ext.data(), x.data(), ws.mat.data(), ws.vec.data());
+    return ws;
+  }
+
+  template <class U>
+  inline void qode1_instance<U>::solve_step(workspace &ws, const U h)
+  {
+    auto timer = stats.time(math::phase::linear_solve);
+    stats.count(math::counter::steps);
+    stats.count(math::counter::factorizations);
+    stats.count(math::counter::solves);
+    kernel(dim(), h, ws.mat.data(), ws.vec.data(), x.data());
+  }
+
+  // -- private ---------------------------------------------------------------
+
+  template <class U>
+  inline U qode1_instance<U>::spectral_radius(const workspace &ws)
+  {
+    auto timer = stats.time(math::phase::spectral_estimate);
+    return math::spectral_radius_estimate(dim(), ws.mat.data());
+  }
+}
@@ -0,0 +1,289 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <ling.hpp>
+#include <qode1.hpp>
+
+// =============================================================================
+//  FILE: qode1_static.hpp  -  qode1 scheme for models known at compile time
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  This file defines qode1_static<U, Model>, the compile-time counterpart of
+//  qode1_core<U>. It integrates the same quadratic system
+//
+//      \dot{x}_i = A_i
+//                  + sum_j     B_{i,j} x_j
+//                  + sum_{j,k} C_{i,j,k} x_j x_k
+//
+//  with the same symmetric scheme and the same stepsize control, but the
+//  coefficients are part of the type instead of being assigned in a virtual
+//  set_coef() on every step.
+//
+//
+//  How to use
+//  ----------
+//  Describe the model as a list of terms:
+//
+//      using model = qode::static_model<2,
+//          qode::b_term<0, 0, 2.0 / 3.0>,
+//          qode::b_term<1, 1, -1.0>,
+//          qode::c_term<0, 0, 1, -4.0 / 3.0>,
+//          qode::c_term<1, 0, 1, 1.0>>;
+//
+//      qode::qode1_static<double, model> core;
+//      core.x = {1.0, 1.0};
+//      core.step_adaptive(h, mu);
+//
+//  Repeated terms accumulate, exactly as repeated assignments through the
+//  proxies of qode1_core do.
+//
+//
+//  Code generation
+//  ---------------
+//  Every entry of the iteration matrix and of the right-hand side is an
+//  expression of its own, built by a fold over the terms. Terms that do not
+//  touch an entry contribute -0.0, which is the exact additive identity and
+//  is removed by the compiler even without relaxed floating point. Entries
+//  that no term touches are emitted as literals, so there is neither a
+//  zero-fill nor a runtime loop over the sparsity pattern. The linear system
+//  is solved by math::solve_opt<n>.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <size_t i, auto value>
+  struct a_term
+  {
+    static constexpr bool touches_mat(size_t, size_t) { return false; }
+    static constexpr bool touches_vec(size_t r) { return r == i; }
+
+    template <class U, size_t r, size_t c>
+    static U mat(const U *) { return U(-0.0); }
+
+    template <class U, size_t r>
+    static U vec(const U *)
+    {
+      if constexpr (r == i)
+        return U(value);
+      else
+        return U(-0.0);
+    }
+  };
+
+  template <size_t i, size_t j, auto value>
+  struct b_term
+  {
+    static constexpr bool touches_mat(size_t r, size_t c) { return r == i && c == j; }
+    static constexpr bool touches_vec(size_t r) { return r == i; }
+
+    template <class U, size_t r, size_t c>
+    static U mat(const U *)
+    {
+      if constexpr (r == i && c == j)
+        return U(value);
+      else
+        return U(-0.0);
+    }
+
+    template <class U, size_t r>
+    static U vec(const U *x)
+    {
+      if constexpr (r == i)
+        return U(value) * x[j] / 2;
+      else
+        return U(-0.0);
+    }
+  };
+
+  template <size_t i, size_t j, size_t k, auto value>
+  struct c_term
+  {
+    static constexpr bool touches_mat(size_t r, size_t c) { return r == i && (c == j || c == k); }
+    static constexpr bool touches_vec(size_t) { return false; }
+
+    template <class U, size_t r, size_t c>
+    static U mat(const U *x)
+    {
+      if constexpr (r == i && c == j && c == k)
+        return 2 * U(value) * x[j];
+      else if constexpr (r == i && c == j)
+        return U(value) * x[k];
+      else if constexpr (r == i && c == k)
+        return U(value) * x[j];
+      else
+        return U(-0.0);
+    }
+
+    template <class U, size_t r>
+    static U vec(const U *) { return U(-0.0); }
+  };
+
+  template <size_t size, class... Terms>
+  struct static_model
+  {
+  };
+
+  template <class U, class Model>
+  class qode1_static;
+
+  template <class U, size_t size, class... Terms>
+  class qode1_static<U, static_model<size, Terms...>>
+  {
+  public:
+    std::array<U, size> x = {};
+
+    static constexpr size_t dim();
+    void step(const U h);
+    void step_adaptive(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0));
+    void adapt_stepsize(U &h, const U mu, const U low_bound = U(0.3), const U high_bound = U(2.0)) const;
+    U suggest_first_stepsize(const U h_max, const U mu) const;
+
+  private:
+    static constexpr size_t n = size;
+
+    template <size_t r, size_t c>
+    static constexpr bool touches_mat = (Terms::touches_mat(r, c) || ...);
+
+    template <size_t r>
+    static constexpr bool touches_vec = (Terms::touches_vec(r) || ...);
+
+    template <size_t r, size_t c>
+    static U mat_entry(const U x[]);
+
+    template <size_t r>
+    static U vec_entry(const U x[]);
+
+    template <size_t... I>
+    static void assemble_jacobian(const U x[], U jac[], std::index_sequence<I...>);
+
+    template <size_t... I>
+    static void assemble_system(const U jac[], const U h, U mat[], std::index_sequence<I...>);
+
+    template <size_t... I>
+    static void assemble_rhs(const U x[], const U h, U rhs[], std::index_sequence<I...>);
+
+    void finish_step(const U jac[], const U h);
+  };
+
+  // -------------------------------------------------------------------------
+  //  qode1_static<U, Model> implementation
+  // -------------------------------------------------------------------------
+
+  // -- public API ------------------------------------------------------------
+
+  template <class U, size_t size, class... Terms>
+  inline constexpr size_t qode1_static<U, static_model<size, Terms...>>::dim()
+  {
+    return n;
+  }
+
+  template <class U, size_t size, class... Terms>
+  inline void qode1_static<U, static_model<size, Terms...>>::step(const U h)
+  {
+    U jac[n * n];
+    assemble_jacobian(x.data(), jac, std::make_index_sequence<n * n>{});
+    finish_step(jac, h);
+  }
+
+  template <class U, size_t size, class... Terms>
+  inline void qode1_static<U, static_model<size, Terms...>>::step_adaptive(U &h, const U mu, const U low_bound, const U high_bound)
+  {
+    U jac[n * n];
+    assemble_jacobian(x.data(), jac, std::make_index_sequence<n * n>{});
+    U omega = math::spectral_radius_estimate(n, jac);
+    h = adapted_stepsize(h, omega, mu, low_bound, high_bound);
+    finish_step(jac, h);
+  }
+
+  template <class U, size_t size, class... Terms>
+  inline void qode1_static<U, static_model<size, Terms...>>::adapt_stepsize(U &h, const U mu, const U low_bound, const U high_bound) const
+  {
+    U jac[n * n];
+    assemble_jacobian(x.data(), jac, std::make_index_sequence<n * n>{});
+    U omega = math::spectral_radius_estimate(n, jac);
+    h = adapted_stepsize(h, omega, mu, low_bound, high_bound);
+  }
+
+  template <class U, size_t size, class... Terms>
+  inline U qode1_static<U, static_model<size, Terms...>>::suggest_first_stepsize(const U h_max, const U mu) const
+  {
+    U jac[n * n];
+    assemble_jacobian(x.data(), jac, std::make_index_sequence<n * n>{});
+    U omega = math::spectral_radius_estimate(n, jac);
+    return mu / std::max(mu / h_max, omega);
+  }
+
+  // -- assembly --------------------------------------------------------------
+
+  template <class U, size_t size, class... Terms>
+  template <size_t r, size_t c>
+  inline U qode1_static<U, static_model<size, Terms...>>::mat_entry(const U x[])
+  {
+    if constexpr (touches_mat<r, c>)
+      return (U(-0.0) + ... + Terms::template mat<U, r, c>(x));
+    else
+      return U(0);
+  }
+
+  template <class U, size_t size, class... Terms>
+  template <size_t r>
+  inline U qode1_static<U, static_model<size, Terms...>>::vec_entry(const U x[])
+  {
+    return (U(-0.0) + ... + Terms::template vec<U, r>(x));
+  }
+
+  template <class U, size_t size, class... Terms>
+  template <size_t... I>
+  inline void qode1_static<U, static_model<size, Terms...>>::assemble_jacobian(const U x[], U jac[], std::index_sequence<I...>)
+  {
+    ((jac[I] = mat_entry<I / n, I % n>(x)), ...);
+  }
+
+  template <class U, size_t size, class... Terms>
+  template <size_t... I>
+  inline void qode1_static<U, static_model<size, Terms...>>::assemble_system(const U jac[], const U h, U mat[], std::index_sequence<I...>)
+  {
+    auto entry = [&]<size_t r, size_t c>()
+    {
+      constexpr U diag = r == c ? U(1) : U(0);
+      if constexpr (touches_mat<r, c>)
+        return diag - h / 2 * jac[n * r + c];
+      else
+        return diag;
+    };
+
+    ((mat[I] = entry.template operator()<I / n, I % n>()), ...);
+  }
+
+  template <class U, size_t size, class... Terms>
+  template <size_t... I>
+  inline void qode1_static<U, static_model<size, Terms...>>::assemble_rhs(const U x[], const U h, U rhs[], std::index_sequence<I...>)
+  {
+    auto entry = [&]<size_t r>()
+    {
+      if constexpr (touches_vec<r>)
+        return x[r] + h * vec_entry<r>(x);
+      else
+        return x[r];
+    };
+
+    ((rhs[I] = entry.template operator()<I>()), ...);
+  }
+
+  // -- private ---------------------------------------------------------------
+
+  template <class U, size_t size, class... Terms>
+  inline void qode1_static<U, static_model<size, Terms...>>::finish_step(const U jac[], const U h)
+  {
+    U mat[n * n], rhs[n];
+    assemble_system(jac, h, mat, std::make_index_sequence<n * n>{});
+    assemble_rhs(x.data(), h, rhs, std::make_index_sequence<n>{});
+    math::solve_opt<n>(mat, rhs);
+    std::copy(rhs, rhs + n, x.begin());
+  }
+}
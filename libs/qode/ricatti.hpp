@@ -0,0 +1,123 @@
+#pragma once
+#include <vector>
+#include <ling.hpp>
+#include <qode1.hpp>
+
+// =============================================================================
+//  FILE: ricatti.hpp  -  exponential linearly implicit integrator
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  ricatti_core<U> integrates the same quadratic (Riccati type) systems
+//
+//      \dot{x}_i = A_i
+//                  + sum_j     B_{i,j} x_j
+//                  + sum_{j,k} C_{i,j,k} x_j x_k
+//
+//  as qode1_core<U> and uses the same A/B/C coefficient interface, but with
+//  the exponential Rosenbrock-Euler step
+//
+//      x_{n+1} = x_n + h phi_1(h J(x_n)) f(x_n),    phi_1(z) = (e^z - 1) / z,
+//
+//  where J(x_n) is the Jacobian assembled by the coefficient proxies.
+//
+//
+//  Properties
+//  ----------
+//  * Order 2, no Newton iterations: the step is linear in f(x_n).
+//  * Exact for the linear part: for C == 0 the step reproduces the exact
+//    solution of \dot{x} = A + B.x for any h.
+//  * Stiff components are damped as by the exact flow (phi_1(z) -> 0 for
+//    z -> -inf), whereas the Cayley factor (1 + z/2) / (1 - z/2) of the
+//    qode1 step tends to -1 and lets them oscillate undamped.
+//  * The step is not symmetric, so composition.hpp does not raise its order.
+//
+//
+//  Cost
+//  ----
+//  phi_1 is evaluated through the exponential of the augmented matrix
+//
+//      exp( [ h J   h f ] )  =  [ e^{hJ}   h phi_1(hJ) f ]
+//           [ 0     0   ]       [ 0        1             ]
+//
+//  by math::expm_pade. This takes about 7 + log2(||h J||) matrix products
+//  per step instead of one LU factorisation, so a step is roughly an order
+//  of magnitude more expensive than a qode1 step; it pays off when
+//  stiffness limits the stepsize of qode1 (see bench_ricatti).
+//
+//
+//  How to use
+//  ----------
+//  As for qode1_core: derive from ricatti_core<U>, override set_coef(),
+//  set `x` and call step(h) or step_adaptive(h, mu). The exponential step
+//  overrides the finish_step hook of qode1_core, so the inherited step /
+//  step_adaptive run it also through a qode1_core<U>& (composition,
+//  richardson_controller, trajectories, steady_state_solver).
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class ricatti_core : public qode1_core<U>
+  {
+  public:
+    explicit ricatti_core(const size_t size);
+
+  protected:
+    // the exponential step replaces the qode1 step of step / step_adaptive
+    void finish_step(const U h) override;
+
+    // finish_step reads mat as J(x), which IMEX mode does not assemble
+    bool supports_imex() const override;
+
+  private:
+    std::vector<U> aug, work;
+  };
+
+  // -------------------------------------------------------------------------
+  //  ricatti_core<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline ricatti_core<U>::ricatti_core(const size_t size) : qode1_core<U>(size)
+  {
+    aug.resize((size + 1) * (size + 1));
+    work.resize(4 * (size + 1) * (size + 1));
+  }
+
+  // -- protected -------------------------------------------------------------
+
+  template <class U>
+  inline bool ricatti_core<U>::supports_imex() const
+  {
+    return false;
+  }
+
+  template <class U>
+  inline void ricatti_core<U>::finish_step(const U h)
+  {
+    const size_t n = this->dim();
+    const size_t m = n + 1;
+    this->stats.count(math::counter::steps);
+    const std::vector<U> &mat = this->mat;
+    const std::vector<U> &vec = this->vec;
+    std::vector<U> &x = this->x;
+
+    for (size_t i = 0; i < n; i++)
+    {
+      const U f_i = vec[i] + math::dot_product(n, mat.data() + n * i, x.data()) / 2;
+      for (size_t j = 0; j < n; j++)
+        aug[m * i + j] = h * mat[n * i + j];
+      aug[m * i + n] = h * f_i;
+    }
+    for (size_t j = 0; j < m; j++)
+      aug[m * n + j] = U(0);
+
+    math::expm_pade(m, aug.data(), work.data());
+
+    for (size_t i = 0; i < n; i++)
+      x[i] += aug[m * i + n];
+  }
+}
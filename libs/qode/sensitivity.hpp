@@ -0,0 +1,206 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <ling.hpp>
+#include <qode1.hpp>
+#include <qode1_model.hpp>
+
+// =============================================================================
+//  FILE: sensitivity.hpp  -  forward parameter sensitivities for qode1
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  qode1_sensitivity<U> is a qode1_instance<U> that also propagates the
+//  sensitivities S = dx/dtheta of the state with respect to every parameter
+//  of its qode1_model, exactly for the discrete qode1 step (the derivative
+//  of the computed trajectory, not of the exact flow).
+//
+//
+//  Sensitivity step
+//  ----------------
+//  Differentiating  M(x_n) x_{n+1} = x_n + h (A + B.x_n/2),
+//  M(x) = I - h/2 J(x), with respect to theta gives
+//
+//      M(x_n) S_{n+1} = (I + h/2 J(x_{n+1})) S_n + G_n,
+//
+//  where column p of G_n is h times the derivative of the symmetric right-hand
+//  side with respect to theta[p] (qode1_model::parameter_derivatives).
+//  All P columns are solved against the LU factors of M(x_n) that the state
+//  step has just produced, by one math::fb_multi substitution: S is stored
+//  row-major (n x P), so the substitution vectorises across the
+//  sensitivities. A step costs one factorisation for any P, plus O(n^2 P)
+//  for the products and substitutions, instead of 1 + P integrations for
+//  finite differences.
+//
+//  The step assembles J(x_{n+1}) for the sensitivity update; that assembly
+//  is kept in the object and reused by the next step as long as x and
+//  theta are unchanged, so a step assembles the model once. The LU factors
+//  are kept in the object as well, not in the per-thread workspace of
+//  qode1_instance, so several instances may step alternately on a thread.
+//
+//
+//  How to use
+//  ----------
+//      qode::qode1_sensitivity<double> run(model);
+//      run.theta = {...};
+//      run.x = {...};
+//      run.reset_sensitivities();       // S = 0 (x(0) independent of theta)
+//      for (...) run.step(h);
+//      double dx0_dtheta1 = run.sensitivity(0, 1);
+//
+//  step_adaptive(h, mu) chooses h from the state, so h depends on theta;
+//  the sensitivities are those of the trajectory for the accepted h.
+//
+//  The sensitivity update overrides the step hooks of qode1_instance
+//  (prepare_step / solve_step), so it also runs when the object is stepped
+//  through a qode1_instance<U>&. save_step_state / restore_step_state
+//  keep S consistent with x under richardson_controller, which discards
+//  trial steps (see step_control.hpp).
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class qode1_sensitivity : public qode1_instance<U>
+  {
+  public:
+    explicit qode1_sensitivity(std::shared_ptr<const qode1_model<U>> model);
+
+    void reset_sensitivities();
+
+    // S <-> saved copy, for step controllers that retract trial steps
+    void save_step_state();
+    void restore_step_state();
+
+    size_t params() const;
+    U sensitivity(const size_t i, const size_t p) const;
+
+    // row-major n x P matrix dx_i / dtheta_p
+    std::vector<U> S;
+
+  protected:
+    using workspace = typename qode1_instance<U>::workspace;
+
+    // the model assembled at the current x and theta, in own storage and
+    // reused while x and theta are unchanged
+    workspace &prepare_step() override;
+
+    // state and sensitivity step from ws == prepare_step()
+    void solve_step(workspace &ws, const U h) override;
+
+  private:
+    std::vector<U> x0, lu, rhs, S_saved;
+
+    // own assembly at x_assembled / theta_assembled
+    workspace own;
+    std::vector<U> x_assembled, theta_assembled;
+    bool assembled = false;
+  };
+
+  // -------------------------------------------------------------------------
+  //  qode1_sensitivity<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline qode1_sensitivity<U>::qode1_sensitivity(std::shared_ptr<const qode1_model<U>> model)
+      : qode1_instance<U>(std::move(model))
+  {
+    const size_t n = this->dim();
+    x0.resize(n);
+    lu.resize(n * n);
+    rhs.resize(n * params());
+    own.mat.resize(n * n);
+    own.vec.resize(n);
+    own.theta_ext.resize(params() + 1);
+    reset_sensitivities();
+  }
+
+  template <class U>
+  inline void qode1_sensitivity<U>::reset_sensitivities()
+  {
+    S.assign(this->dim() * params(), U(0));
+  }
+
+  template <class U>
+  inline void qode1_sensitivity<U>::save_step_state()
+  {
+    S_saved.assign(S.begin(), S.end());
+  }
+
+  template <class U>
+  inline void qode1_sensitivity<U>::restore_step_state()
+  {
+    std::copy(S_saved.begin(), S_saved.end(), S.begin());
+  }
+
+  template <class U>
+  inline size_t qode1_sensitivity<U>::params() const
+  {
+    return this->model->params();
+  }
+
+  template <class U>
+  inline U qode1_sensitivity<U>::sensitivity(const size_t i, const size_t p) const
+  {
+    return S[params() * i + p];
+  }
+
+  // -- protected -------------------------------------------------------------
+
+  template <class U>
+  inline typename qode1_sensitivity<U>::workspace &qode1_sensitivity<U>::prepare_step()
+  {
+    if (assembled && this->x == x_assembled && this->theta == theta_assembled)
+      return own;
+
+    auto timer = this->stats.time(math::phase::assemble);
+    this->stats.count(math::counter::assemblies);
+    own.theta_ext[0] = U(1);
+    std::copy(this->theta.begin(), this->theta.end(), own.theta_ext.begin() + 1);
+    this->model->assemble(own.theta_ext.data(), this->x.data(), own.mat.data(), own.vec.data());
+    x_assembled = this->x;
+    theta_assembled = this->theta;
+    assembled = true;
+    return own;
+  }
+
+  template <class U>
+  inline void qode1_sensitivity<U>::solve_step(workspace &ws, const U h)
+  {
+    const size_t n = this->dim();
+    const size_t m = params();
+
+    this->stats.count(math::counter::steps);
+    this->stats.count(math::counter::factorizations);
+    this->stats.count(math::counter::solves, 1 + m);
+
+    // state step; the LU factors of M(x_n) are left in lu
+    std::copy(this->x.begin(), this->x.end(), x0.begin());
+    std::copy(ws.mat.begin(), ws.mat.end(), lu.begin());
+    symmetric_update(n, h, lu.data(), ws.vec.data(), this->x.data());
+
+    // J(x_{n+1}) in own.mat, kept for the next step
+    const std::vector<U> &jac = prepare_step().mat;
+
+    // rhs = S + h/2 J(x_{n+1}) S + G
+    std::copy(S.begin(), S.end(), rhs.begin());
+    for (size_t i = 0; i < n; i++)
+    {
+      U *rhs_i = rhs.data() + m * i;
+      for (size_t k = 0; k < n; k++)
+      {
+        const U a_ik = h / 2 * jac[n * i + k];
+        const U *s_k = S.data() + m * k;
+        for (size_t r = 0; r < m; r++)
+          rhs_i[r] += a_ik * s_k[r];
+      }
+    }
+    this->model->parameter_derivatives(h, x0.data(), this->x.data(), rhs.data());
+
+    math::fb_multi(n, m, lu.data(), rhs.data());
+    S.swap(rhs);
+  }
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <ling.hpp>
+
+// =============================================================================
+//  FILE: steady_state.hpp  -  equilibria f(x) = 0 of a quadratic system
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  Integrating to t -> infinity to find an equilibrium takes thousands of
+//  steps. steady_state_solver<U> finds it from the same A/B/C assembly by
+//  damped Newton with pseudo-transient continuation (PTC):
+//
+//      (I / tau - J(x)) dx = f(x),     x <- x + lambda dx.
+//
+//  For small tau this is a linearised implicit Euler step of length tau
+//  (robust far from the equilibrium), for tau -> infinity Newton's method
+//  (quadratic convergence close to it). tau follows the residual
+//  (switched evolution relaxation),
+//
+//      tau <- tau * |f(x_old)| / |f(x_new)|,
+//
+//  and becomes pure Newton (shift 0) at tau_max. Continuation steps are
+//  taken as they are unless the residual grows by more than max_growth
+//  (the residual need not decrease along a transient); in Newton steps the
+//  damping lambda is halved up to max_halvings times until the residual
+//  decreases. A rejected step shrinks tau by a factor of 4. After
+//  max_failures consecutive rejections the solver falls back to
+//  `fallback_steps` steps of step_adaptive(h, mu) of the integrator and
+//  restarts the continuation.
+//
+//
+//  How to use
+//  ----------
+//      qode::steady_state_solver<double> solver;
+//      solver.tol = 1e-12;
+//      auto res = solver.solve(core);       // core.x is the initial guess
+//      if (res.converged) ... core.x ...
+//
+//  Any integrator with a public state `x`, dim(), evaluate(f, jac) and
+//  step_adaptive / suggest_first_stepsize can be used (qode1_core). The
+//  residual is |f(x)|_inf. Like the qode1 step, the linear solves use LU
+//  without pivoting.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  struct steady_state_result
+  {
+    bool converged = false;
+    U residual = U(0);
+    size_t iterations = 0;      // accepted PTC / Newton updates
+    size_t evaluations = 0;     // evaluate() calls
+    size_t factorizations = 0;
+    size_t fallback_steps = 0;  // step_adaptive calls
+  };
+
+  template <class U>
+  class steady_state_solver
+  {
+  public:
+    U tol = U(1e-10);
+    U tau_start = U(1);
+    U tau_max = U(1e8);
+    size_t max_iterations = 200;
+    U max_growth = U(4);
+    int max_halvings = 6;
+    int max_failures = 4;
+
+    size_t fallback_steps = 100;
+    int max_fallbacks = 10;
+    U mu = U(0.03);
+
+    template <class Core>
+    steady_state_result<U> solve(Core &core);
+
+  private:
+    std::vector<U> f, f_trial, jac, dx, x_old;
+
+    static U norm(const std::vector<U> &v);
+  };
+
+  // -------------------------------------------------------------------------
+  //  steady_state_solver<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline U steady_state_solver<U>::norm(const std::vector<U> &v)
+  {
+    using std::abs;
+    U r = U(0);
+    for (const U value : v)
+      if (!(abs(value) <= r)) // propagates NaN
+        r = abs(value);
+    return r;
+  }
+
+  template <class U>
+  template <class Core>
+  inline steady_state_result<U> steady_state_solver<U>::solve(Core &core)
+  {
+    const size_t n = core.dim();
+    f.resize(n);
+    f_trial.resize(n);
+    jac.resize(n * n);
+    dx.resize(n);
+    x_old.resize(n);
+
+    steady_state_result<U> res;
+    core.evaluate(f.data(), jac.data());
+    res.evaluations++;
+    res.residual = norm(f);
+
+    U tau = tau_start;
+    int failures = 0, fallbacks = 0;
+
+    while (res.iterations < max_iterations)
+    {
+      if (res.residual <= tol)
+      {
+        res.converged = true;
+        break;
+      }
+
+      // (I / tau - J) dx = f; jac is overwritten by the LU factors
+      const U shift = tau < tau_max ? U(1) / tau : U(0);
+      for (size_t i = 0; i < n; i++)
+      {
+        for (size_t j = 0; j < n; j++)
+          jac[n * i + j] = -jac[n * i + j];
+        jac[n * i + i] += shift;
+      }
+      std::copy(f.begin(), f.end(), dx.begin());
+      math::lu_naive(n, jac.data());
+      math::fb_naive(n, jac.data(), dx.data());
+      res.factorizations++;
+
+      // continuation steps are taken unless the residual grows by more
+      // than max_growth; Newton steps are damped until it decreases
+      const bool newton = shift == U(0);
+      const U limit = newton ? res.residual : max_growth * res.residual;
+      std::copy(core.x.begin(), core.x.end(), x_old.begin());
+      U lambda = U(1), r_trial = std::numeric_limits<U>::infinity();
+      for (int k = 0; k <= (newton ? max_halvings : 0); k++, lambda /= 2)
+      {
+        for (size_t i = 0; i < n; i++)
+          core.x[i] = x_old[i] + lambda * dx[i];
+        core.evaluate(f_trial.data(), jac.data());
+        res.evaluations++;
+        r_trial = norm(f_trial);
+        if (r_trial < limit)
+          break;
+      }
+
+      if (r_trial < limit)
+      {
+        tau = std::min(tau * res.residual / std::max(r_trial, std::numeric_limits<U>::min()), tau_max);
+        f.swap(f_trial);
+        res.residual = r_trial;
+        res.iterations++;
+        failures = 0;
+        continue;
+      }
+
+      std::copy(x_old.begin(), x_old.end(), core.x.begin());
+      tau /= 4;
+      if (++failures < max_failures)
+      {
+        core.evaluate(f.data(), jac.data());
+        res.evaluations++;
+        continue;
+      }
+
+      // continuation stalled: integrate for a while and restart from there
+      if (fallbacks++ == max_fallbacks)
+        break;
+      U h = core.suggest_first_stepsize(U(1), mu);
+      for (size_t s = 0; s < fallback_steps; s++)
+        core.step_adaptive(h, mu);
+      res.fallback_steps += fallback_steps;
+
+      core.evaluate(f.data(), jac.data());
+      res.evaluations++;
+      res.residual = norm(f);
+      tau = tau_start;
+      failures = 0;
+    }
+
+    if (res.residual <= tol)
+      res.converged = true;
+    return res;
+  }
+}
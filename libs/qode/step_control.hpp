@@ -0,0 +1,224 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <stats.hpp>
+
+// =============================================================================
+//  FILE: step_control.hpp  -  local error control by step doubling
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  step_adaptive(h, mu) of qode1_core keeps spectral_radius * h = mu and has
+//  no accuracy estimate. richardson_controller<U> chooses h from a local
+//  error tolerance instead.
+//
+//
+//  Error estimate
+//  --------------
+//  The qode1 step Phi_h is symmetric, so its local error expansion contains
+//  only odd powers of h:
+//
+//      Phi_h(x) - phi_h(x) = e_3(x) h^3 + e_5(x) h^5 + ...
+//
+//  One step of size h (x_1) and two steps of size h/2 (x_2) give
+//
+//      err = (x_2 - x_1) / 3  =  phi_h(x) - x_2  +  O(h^5),
+//
+//  the local error of x_2 with the opposite sign (only its norm is used
+//  below). The Richardson estimate is accurate to two orders, not one, and
+//  the extrapolated value x_2 + err has local error O(h^5).
+//
+//  The step is accepted when
+//
+//      || err_i / (atol + rtol * max(|x_i|, |x_2,i|)) ||_rms <= 1,
+//
+//  and the next stepsize is h * clamp(safety * norm^{-1/3}, fac_min, fac_max).
+//  A rejected step restores x and is retried with the reduced h.
+//  The tolerance bounds the error committed per step; the global error of
+//  a run grows roughly with the number of steps (see bench_step_control).
+//
+//
+//  How to use
+//  ----------
+//      qode::richardson_controller<double> ctrl(1e-8, 1e-8);
+//      double h = 0.1;
+//      while (t < t_end)
+//        t += ctrl.step(core, h, t_end - t);
+//
+//  Any integrator with a public state `x` and step(h) can be controlled
+//  (qode1_core, qode1_instance, qode1_static). The controlled step costs
+//  three steps of the underlying integrator.
+//
+//  The trial step of size h and rejected steps are retracted by restoring
+//  x. Integrators that carry state of their own along the trajectory
+//  (qode1_sensitivity: S, qode1_lyapunov: the tangent vectors) provide
+//
+//      void save_step_state();       // called with x == x_n
+//      void restore_step_state();    // back to the state at the last save
+//
+//  which the controller calls together with its copy of x, so that this
+//  state follows the accepted steps only.
+//
+//  With extrapolate == true the accepted value is x_2 + err (order 4, not
+//  symmetric); otherwise it is x_2, which keeps the symmetric scheme and
+//  uses err only to choose h. The state of save_step_state belongs to x_2
+//  also when extrapolating.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  class richardson_controller
+  {
+  public:
+    U atol, rtol;
+    U safety = U(0.9);
+    U fac_min = U(0.2);
+    U fac_max = U(4.0);
+    bool extrapolate = false;
+    int max_rejections = 50;
+
+    size_t accepted = 0;
+    size_t rejected = 0;
+
+    richardson_controller(const U atol, const U rtol);
+
+    // performs one accepted step with |h_taken| <= |h_limit|, returns h_taken
+    // and leaves the proposal for the next step in h
+    template <class Core>
+    U step(Core &core, U &h, const U h_limit);
+
+    template <class Core>
+    U step(Core &core, U &h);
+
+    // scaled rms norm of the last error estimate
+    U last_error() const;
+
+  private:
+    std::vector<U> x0, x1;
+    U err_norm = U(0);
+
+    template <class Core>
+    U try_step(Core &core, const U h);
+
+    // x and the integrator's own state <- those at the start of try_step
+    template <class Core>
+    void restore(Core &core);
+  };
+
+  // -------------------------------------------------------------------------
+  //  richardson_controller<U> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U>
+  inline richardson_controller<U>::richardson_controller(const U atol, const U rtol) : atol(atol), rtol(rtol)
+  {
+    if (!(atol >= U(0) && rtol >= U(0) && atol + rtol > U(0)))
+      throw std::invalid_argument("richardson_controller: tolerances must be non-negative and not both zero");
+  }
+
+  template <class U>
+  template <class Core>
+  inline U richardson_controller<U>::step(Core &core, U &h)
+  {
+    return step(core, h, h);
+  }
+
+  template <class U>
+  template <class Core>
+  inline U richardson_controller<U>::step(Core &core, U &h, const U h_limit)
+  {
+    using std::abs;
+    using std::pow;
+
+    const U h_proposed = h;
+    bool limited = false;
+    if (abs(h) > abs(h_limit))
+    {
+      h = h_limit;
+      limited = true;
+    }
+
+    for (int attempt = 0; attempt <= max_rejections; ++attempt)
+    {
+      const U norm = try_step(core, h);
+      const U factor = norm > U(0) ? std::clamp(safety * pow(norm, U(-1) / U(3)), fac_min, fac_max) : fac_max;
+
+      if (norm <= U(1))
+      {
+        ++accepted;
+        const U h_taken = h;
+        // a step shortened to h_limit says nothing against the proposal
+        h = limited ? h_proposed : h * factor;
+        return h_taken;
+      }
+
+      ++rejected;
+      if constexpr (requires { core.stats; })
+        core.stats.count(math::counter::rejected_steps);
+      restore(core);
+      h *= std::min(factor, U(1) / U(2));
+      limited = false;
+    }
+
+    throw std::runtime_error("richardson_controller: too many rejected steps");
+  }
+
+  template <class U>
+  inline U richardson_controller<U>::last_error() const
+  {
+    return err_norm;
+  }
+
+  // -- private ---------------------------------------------------------------
+
+  template <class U>
+  template <class Core>
+  inline U richardson_controller<U>::try_step(Core &core, const U h)
+  {
+    using std::abs;
+    using std::sqrt;
+
+    const size_t n = core.x.size();
+    x0.assign(core.x.begin(), core.x.end());
+    if constexpr (requires { core.save_step_state(); })
+      core.save_step_state();
+
+    core.step(h);
+    x1.assign(core.x.begin(), core.x.end());
+
+    restore(core);
+    core.step(h / 2);
+    core.step(h / 2);
+
+    U sum = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U err = (core.x[i] - x1[i]) / U(3);
+      const U scale = atol + rtol * std::max(abs(x0[i]), abs(core.x[i]));
+      sum += (err / scale) * (err / scale);
+
+      if (extrapolate)
+        x1[i] = core.x[i] + err;
+    }
+    err_norm = n > 0 ? sqrt(sum / U(n)) : U(0);
+
+    if (extrapolate)
+      std::copy(x1.begin(), x1.end(), core.x.begin());
+
+    return err_norm;
+  }
+
+  template <class U>
+  template <class Core>
+  inline void richardson_controller<U>::restore(Core &core)
+  {
+    std::copy(x0.begin(), x0.end(), core.x.begin());
+    if constexpr (requires { core.restore_step_state(); })
+      core.restore_step_state();
+  }
+}
@@ -0,0 +1,271 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <cmath>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <condition_variable>
+#include <generator.hpp>
+#include <step_control.hpp>
+
+// =============================================================================
+//  FILE: trajectory.hpp  -  lazy trajectories as coroutine generators
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  Instead of a hand-written loop around step_adaptive, a trajectory is a
+//  math::generator of trajectory_point {t, h, x}, where x is a view of the
+//  integrator's own state (no copy; valid until the next point is pulled)
+//  and h the step that led to it (0 for the initial point). The integrator
+//  advances only when the consumer asks for the next point.
+//
+//  Sources (any integrator with a public state `x` and the named methods):
+//
+//      adaptive_trajectory(core, t, t_end, h, mu)      step_adaptive(h, mu)
+//                                                      until t >= t_end
+//      fixed_trajectory(core, t, t_end, h)             step(h'), h' <= h
+//                                                      ending at t_end
+//      controlled_trajectory(ctrl, core, t, t_end, h)  richardson_controller
+//                                                      steps ending at t_end
+//
+//  Adaptors (take a generator, return a generator):
+//
+//      decimate(g, k)         every k-th point, starting with the first;
+//                             k == 0 throws std::invalid_argument
+//      sample(g, times)       points at the sorted output times, linearly
+//                             interpolated between steps (O(h^2), the order
+//                             of the qode1 step)
+//      until(g, stop)         points up to and including the first p
+//                             with stop(p) == true
+//
+//  Breaking out of a range-for ends the integration early as well.
+//
+//      for (const auto &p : decimate(adaptive_trajectory(core, 0.0, 50.0, h, 0.03), 10))
+//        out << p.t << ' ' << p.x[0] << '\n';
+//
+//  consume_async(g, capacity, consumer) runs consumer(p) on a separate
+//  thread, fed through a ring of `capacity` copied points, so that e.g. a
+//  writer overlaps with the integration. Exceptions of either side are
+//  rethrown in the caller.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U>
+  struct trajectory_point
+  {
+    U t;
+    U h;
+    std::span<const U> x;
+  };
+
+  template <class U>
+  using trajectory = math::generator<trajectory_point<U>>;
+
+  // -------------------------------------------------------------------------
+  //  sources
+  // -------------------------------------------------------------------------
+
+  template <class Core, class U>
+  trajectory<U> adaptive_trajectory(Core &core, U t, const U t_end, U h, const U mu)
+  {
+    co_yield trajectory_point<U>{t, U(0), core.x};
+    while (t < t_end)
+    {
+      core.step_adaptive(h, mu);
+      t += h;
+      co_yield trajectory_point<U>{t, h, core.x};
+    }
+  }
+
+  template <class Core, class U>
+  trajectory<U> fixed_trajectory(Core &core, const U t0, const U t_end, const U h)
+  {
+    using std::ceil;
+    const size_t steps = size_t(ceil((t_end - t0) / h - U(1e-9)));
+    const U h_step = steps ? (t_end - t0) / U(steps) : U(0);
+
+    co_yield trajectory_point<U>{t0, U(0), core.x};
+    for (size_t i = 1; i <= steps; i++)
+    {
+      core.step(h_step);
+      co_yield trajectory_point<U>{i == steps ? t_end : t0 + U(i) * h_step, h_step, core.x};
+    }
+  }
+
+  template <class Core, class U>
+  trajectory<U> controlled_trajectory(richardson_controller<U> &ctrl, Core &core, U t, const U t_end, U h)
+  {
+    co_yield trajectory_point<U>{t, U(0), core.x};
+    while (t < t_end)
+    {
+      const U taken = ctrl.step(core, h, t_end - t);
+      t = t_end - t > taken ? t + taken : t_end;
+      co_yield trajectory_point<U>{t, taken, core.x};
+    }
+  }
+
+  // -------------------------------------------------------------------------
+  //  adaptors
+  // -------------------------------------------------------------------------
+
+  namespace trajectory_detail
+  {
+    template <class U>
+    trajectory<U> decimate(trajectory<U> points, const size_t every)
+    {
+      size_t i = 0;
+      for (const trajectory_point<U> &p : points)
+        if (i++ % every == 0)
+          co_yield p;
+    }
+  }
+
+  // not a coroutine itself, so that every == 0 throws at the call
+  template <class U>
+  trajectory<U> decimate(trajectory<U> points, const size_t every)
+  {
+    if (every == 0)
+      throw std::invalid_argument("decimate: every must be at least 1");
+    return trajectory_detail::decimate(std::move(points), every);
+  }
+
+  template <class U>
+  trajectory<U> sample(trajectory<U> points, std::vector<U> times)
+  {
+    std::vector<U> prev, buffer;
+    U t_prev = U(0);
+    auto next = times.begin();
+
+    for (const trajectory_point<U> &p : points)
+    {
+      for (; next != times.end() && *next <= p.t; ++next)
+      {
+        if (*next == p.t)
+        {
+          co_yield trajectory_point<U>{*next, p.h, p.x};
+          continue;
+        }
+        if (prev.empty() || *next < t_prev)
+          continue; // before the first point
+
+        const U w = (*next - t_prev) / (p.t - t_prev);
+        buffer.resize(p.x.size());
+        for (size_t i = 0; i < buffer.size(); i++)
+          buffer[i] = prev[i] + w * (p.x[i] - prev[i]);
+        co_yield trajectory_point<U>{*next, p.h, buffer};
+      }
+      if (next == times.end())
+        co_return;
+
+      prev.assign(p.x.begin(), p.x.end());
+      t_prev = p.t;
+    }
+  }
+
+  template <class U, class Stop>
+  trajectory<U> until(trajectory<U> points, Stop stop)
+  {
+    for (const trajectory_point<U> &p : points)
+    {
+      co_yield p;
+      if (stop(p))
+        co_return;
+    }
+  }
+
+  // -------------------------------------------------------------------------
+  //  consume_async
+  // -------------------------------------------------------------------------
+
+  template <class U, class Consumer>
+  void consume_async(trajectory<U> points, const size_t capacity, Consumer &&consumer)
+  {
+    struct slot
+    {
+      U t, h;
+      std::vector<U> x;
+    };
+
+    std::vector<slot> ring(std::max<size_t>(capacity, 1));
+    size_t head = 0, tail = 0; // slots [tail, head) are filled
+    bool finished = false, failed = false;
+    std::exception_ptr consumer_error;
+    std::mutex m;
+    std::condition_variable filled, freed;
+
+    std::thread worker([&]
+                       {
+                         try
+                         {
+                           while (true)
+                           {
+                             std::unique_lock<std::mutex> lock(m);
+                             filled.wait(lock, [&]
+                                         { return tail != head || finished; });
+                             if (tail == head)
+                               return;
+                             slot &s = ring[tail % ring.size()];
+                             lock.unlock();
+
+                             consumer(trajectory_point<U>{s.t, s.h, s.x});
+
+                             lock.lock();
+                             tail++;
+                             freed.notify_one();
+                           }
+                         }
+                         catch (...)
+                         {
+                           std::lock_guard<std::mutex> lock(m);
+                           consumer_error = std::current_exception();
+                           failed = true;
+                           freed.notify_one();
+                         } });
+
+    std::exception_ptr producer_error;
+    try
+    {
+      for (const trajectory_point<U> &p : points)
+      {
+        std::unique_lock<std::mutex> lock(m);
+        freed.wait(lock, [&]
+                   { return head - tail < ring.size() || failed; });
+        if (failed)
+          break;
+        slot &s = ring[head % ring.size()];
+        lock.unlock();
+
+        s.t = p.t;
+        s.h = p.h;
+        s.x.assign(p.x.begin(), p.x.end());
+
+        lock.lock();
+        head++;
+        filled.notify_one();
+      }
+    }
+    catch (...)
+    {
+      producer_error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m);
+      finished = true;
+    }
+    filled.notify_one();
+    worker.join();
+
+    if (consumer_error)
+      std::rethrow_exception(consumer_error);
+    if (producer_error)
+      std::rethrow_exception(producer_error);
+  }
+}
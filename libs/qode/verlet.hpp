@@ -1,2 +1,244 @@
 #pragma once
-//#include <ricatti.hpp>
\ No newline at end of file
+#include <array>
+#include <vector>
+#include <type_traits>
+#include <composition.hpp>
+
+// =============================================================================
+//  FILE: verlet.hpp  -  explicit symplectic integrators for separable systems
+// =============================================================================
+//
+//  Purpose
+//  -------
+//  For non-stiff Hamiltonian systems
+//
+//      H(x, u) = |u|^2 / 2 + V(x),      \dot{x} = u,   \dot{u} = a(x) = -grad V,
+//
+//  the implicit qode1 step with its LU factorisation is unnecessary work.
+//  verlet<U, n> integrates them explicitly with velocity Verlet
+//
+//      u <- u + h/2 a(x),   x <- x + h u,   u <- u + h/2 a(x),
+//
+//  which is symplectic, symmetric and of order 2, and with symmetric
+//  compositions of it (composition.hpp) of order 4, 6, 8.
+//
+//
+//  How to use
+//  ----------
+//  1) Derive a class from verlet<U, n>; n > 0 fixes the dimension at compile
+//     time (std::array storage), n == 0 takes it in the constructor
+//     (std::vector storage).
+//  2) Override
+//
+//        void acceleration(const U x[], U a[]);
+//
+//  3) Set the positions `x` and velocities `u`.
+//  4) Use
+//
+//        step(h)                   velocity Verlet
+//        step(h, composition)      composed step of higher order
+//
+//  If `x` is modified between steps, call x_changed() (see below).
+//
+//
+//  Cost
+//  ----
+//  The acceleration at the end of a step is kept for the first kick of the
+//  next one (first same as last), so velocity Verlet costs one evaluation of
+//  a(x) per step and a composition with s substeps costs s evaluations, the
+//  kicks of adjacent substeps being merged into one. Since the cached value
+//  belongs to the last computed x, x_changed() must be called after `x` is
+//  assigned from outside.
+//
+//
+//  Layout
+//  ------
+//  x, u and a are flat arrays of length n. For many particles in d
+//  dimensions use the structure-of-arrays layout of particle_system<U, d>,
+//
+//      x = [ x_0 .. x_{N-1} | y_0 .. y_{N-1} | z_0 .. z_{N-1} ],
+//
+//  so that the updates and typical force loops run over contiguous memory
+//  and vectorise.
+//
+// =============================================================================
+
+namespace qode
+{
+  template <class U, size_t n = 0>
+  class verlet
+  {
+  public:
+    using storage = std::conditional_t<n == 0, std::vector<U>, std::array<U, n>>;
+
+    storage x{}, u{};
+
+    verlet()
+      requires(n > 0)
+    = default;
+
+    explicit verlet(const size_t size)
+      requires(n == 0);
+
+    virtual ~verlet() = default;
+
+    virtual void acceleration(const U x[], U a[]) = 0;
+
+    size_t dim() const;
+    void step(const U h);
+    void step(const U h, const composition<U> &scheme);
+    void x_changed();
+
+  private:
+    storage a{};
+    bool a_valid = false;
+
+    void kick(const U h);
+    void drift(const U h);
+    void update_acceleration();
+  };
+
+  // -------------------------------------------------------------------------
+  //  particle_system<U, d>
+  // -------------------------------------------------------------------------
+  //  verlet<U> for N particles in d dimensions in structure-of-arrays
+  //  layout: component c of particle p is stored at index c * N + p.
+  // -------------------------------------------------------------------------
+
+  template <class U, size_t d>
+  class particle_system : public verlet<U>
+  {
+  public:
+    explicit particle_system(const size_t particles);
+
+    size_t particles() const;
+
+    U *x_of(const size_t c);
+    U *u_of(const size_t c);
+    const U *x_of(const size_t c) const;
+    const U *u_of(const size_t c) const;
+
+  private:
+    size_t n_particles;
+  };
+
+  // -------------------------------------------------------------------------
+  //  verlet<U, n> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U, size_t n>
+  inline verlet<U, n>::verlet(const size_t size)
+    requires(n == 0)
+      : x(size, U(0)), u(size, U(0)), a(size, U(0))
+  {
+  }
+
+  template <class U, size_t n>
+  inline size_t verlet<U, n>::dim() const
+  {
+    return x.size();
+  }
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::step(const U h)
+  {
+    if (!a_valid)
+      update_acceleration();
+
+    kick(h / 2);
+    drift(h);
+    update_acceleration();
+    kick(h / 2);
+  }
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::step(const U h, const composition<U> &scheme)
+  {
+    const std::vector<U> &g = scheme.coefficients();
+    const size_t s = g.size();
+
+    if (!a_valid)
+      update_acceleration();
+
+    kick(g[0] * h / 2);
+    for (size_t i = 0; i < s; ++i)
+    {
+      drift(g[i] * h);
+      update_acceleration();
+      kick((i + 1 < s ? g[i] + g[i + 1] : g[i]) * h / 2);
+    }
+  }
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::x_changed()
+  {
+    a_valid = false;
+  }
+
+  // -- private ---------------------------------------------------------------
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::kick(const U h)
+  {
+    const size_t m = dim();
+    for (size_t i = 0; i < m; ++i)
+      u[i] += h * a[i];
+  }
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::drift(const U h)
+  {
+    const size_t m = dim();
+    for (size_t i = 0; i < m; ++i)
+      x[i] += h * u[i];
+  }
+
+  template <class U, size_t n>
+  inline void verlet<U, n>::update_acceleration()
+  {
+    if constexpr (n == 0)
+      a.resize(x.size());
+
+    acceleration(x.data(), a.data());
+    a_valid = true;
+  }
+
+  // -------------------------------------------------------------------------
+  //  particle_system<U, d> implementation
+  // -------------------------------------------------------------------------
+
+  template <class U, size_t d>
+  inline particle_system<U, d>::particle_system(const size_t particles) : verlet<U>(d * particles), n_particles(particles)
+  {
+  }
+
+  template <class U, size_t d>
+  inline size_t particle_system<U, d>::particles() const
+  {
+    return n_particles;
+  }
+
+  template <class U, size_t d>
+  inline U *particle_system<U, d>::x_of(const size_t c)
+  {
+    return this->x.data() + c * n_particles;
+  }
+
+  template <class U, size_t d>
+  inline U *particle_system<U, d>::u_of(const size_t c)
+  {
+    return this->u.data() + c * n_particles;
+  }
+
+  template <class U, size_t d>
+  inline const U *particle_system<U, d>::x_of(const size_t c) const
+  {
+    return this->x.data() + c * n_particles;
+  }
+
+  template <class U, size_t d>
+  inline const U *particle_system<U, d>::u_of(const size_t c) const
+  {
+    return this->u.data() + c * n_particles;
+  }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+// =============================================================================
+//  FILE: gauss_legendre.hpp  -  compile-time Gauss-Legendre Butcher tables
+// =============================================================================
+//
+//  gauss_legendre<U, s>() returns the Butcher table of the s-stage
+//  Gauss-Legendre collocation method (order 2s) computed entirely with the
+//  arithmetic of U, so it is usable in constant expressions for every U with
+//  constexpr +, -, *, / and comparisons (float, double, long double,
+//  math::double_double).
+//
+//  Construction
+//  ------------
+//  * Nodes: the roots of the Legendre polynomial P_s interlace the roots of
+//    P_{s-1}; starting from the root of P_1 every root of P_k is isolated
+//    between two roots of P_{k-1} (or +-1) and found by bisection in double.
+//    The roots of P_s are then polished by Newton steps in U until they
+//    stop changing, which keeps the compile-time cost low for wide types.
+//  * Weights: b_m = 1 / ((1 - x_m^2) P_s'(x_m)^2) on [0, 1].
+//  * Coefficients: a_ij = int_0^{c_i} l_j(t) dt for the Lagrange basis l_j.
+//    The integrand has degree s - 1, so the s-point Gauss rule mapped to
+//    [0, c_i] integrates it exactly; l_j is evaluated in product form.
+//    This avoids the monomial expansion and its cancellation.
+//
+//  Layout is that of rkgl::A: rows 0..s-1 hold a_ij, row s holds b_j.
+// =============================================================================
+
+namespace rkgl
+{
+  template <class U, int s>
+  struct gauss_legendre_table
+  {
+    U a[s + 1][s] = {};
+    U c[s] = {};
+  };
+
+  namespace gl_detail
+  {
+    // returns P_k(x) and stores P_{k-1}(x) in prev
+    template <class U>
+    constexpr U legendre(const int k, const U x, U &prev)
+    {
+      U p0 = U(1), p1 = x;
+      if (k == 0)
+      {
+        prev = U(0);
+        return p0;
+      }
+      for (int m = 1; m < k; ++m)
+      {
+        const U p2 = (U(2 * m + 1) * x * p1 - U(m) * p0) / U(m + 1);
+        p0 = p1;
+        p1 = p2;
+      }
+      prev = p0;
+      return p1;
+    }
+
+    template <class U>
+    constexpr U legendre(const int k, const U x)
+    {
+      U prev = U(0);
+      return legendre(k, x, prev);
+    }
+
+    // root of P_k in (lo, hi): bisection in double, then Newton steps in U
+    template <class U>
+    constexpr U find_root(const int k, double lo, double hi)
+    {
+      double f_lo = legendre(k, lo);
+      for (int it = 0; it < 64; ++it)
+      {
+        const double mid = (lo + hi) / 2;
+        if (!(lo < mid && mid < hi))
+          break;
+        const double f_mid = legendre(k, mid);
+        if ((f_mid < 0.0) == (f_lo < 0.0))
+        {
+          lo = mid;
+          f_lo = f_mid;
+        }
+        else
+          hi = mid;
+      }
+
+      U x = U((lo + hi) / 2);
+      for (int it = 0; it < 8; ++it)
+      {
+        U prev = U(0);
+        const U p = legendre(k, x, prev);
+        const U dp = U(k) * (prev - x * p) / (U(1) - x * x);
+        const U x_new = x - p / dp;
+        if (x_new == x)
+          break;
+        x = x_new;
+      }
+      return x;
+    }
+  }
+
+  template <class U, int s>
+  constexpr gauss_legendre_table<U, s> gauss_legendre()
+  {
+    static_assert(s >= 1, "Gauss-Legendre method needs at least one stage");
+
+    // roots of P_1 .. P_s on [-1, 1], ascending, bracketed in double
+    double brackets[s] = {};
+    double next[s] = {};
+
+    for (int k = 2; k <= s; ++k)
+    {
+      for (int r = 0; r < k; ++r)
+      {
+        const double lo = r == 0 ? -1.0 : brackets[r - 1];
+        const double hi = r == k - 1 ? 1.0 : brackets[r];
+        next[r] = double(gl_detail::find_root<double>(k, lo, hi));
+      }
+      for (int r = 0; r < k; ++r)
+        brackets[r] = next[r];
+    }
+
+    // final roots of P_s polished in U
+    U roots[s] = {};
+    for (int r = 0; r < s; ++r)
+    {
+      const double lo = r == 0 ? -1.0 : (brackets[r - 1] + brackets[r]) / 2;
+      const double hi = r == s - 1 ? 1.0 : (brackets[r] + brackets[r + 1]) / 2;
+      roots[r] = s == 1 ? U(0) : gl_detail::find_root<U>(s, lo, hi);
+    }
+
+    gauss_legendre_table<U, s> t;
+    U b[s] = {};
+
+    for (int m = 0; m < s; ++m)
+    {
+      U prev = U(0);
+      const U x = roots[m];
+      const U p = gl_detail::legendre(s, x, prev);
+      const U dp = U(s) * (prev - x * p) / (U(1) - x * x);
+      b[m] = U(1) / ((U(1) - x * x) * dp * dp);
+      t.c[m] = (U(1) + x) / 2;
+    }
+
+    auto lagrange = [&](const int j, const U tau)
+    {
+      U l = U(1);
+      for (int m = 0; m < s; ++m)
+        if (m != j)
+          l *= (tau - t.c[m]) / (t.c[j] - t.c[m]);
+      return l;
+    };
+
+    for (int i = 0; i < s; ++i)
+      for (int j = 0; j < s; ++j)
+      {
+        U sum = U(0);
+        for (int m = 0; m < s; ++m)
+          sum += b[m] * lagrange(j, t.c[i] * t.c[m]);
+        t.a[i][j] = t.c[i] * sum;
+      }
+
+    for (int j = 0; j < s; ++j)
+      t.a[s][j] = b[j];
+
+    return t;
+  }
+
+  template <class U, int s>
+  inline constexpr gauss_legendre_table<U, s> gauss_legendre_v = gauss_legendre<U, s>();
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <ling.hpp>
+#include <dual.hpp>
+#include <stats.hpp>
 #include <buffer.hpp>
 
 namespace rkgl
@@ -10,43 +13,190 @@ namespace rkgl
   class mini_jacobian
   {
   public:
+    [[no_unique_address]] math::solver_stats<> stats;
+
+    // Euclidean covector, fused single-pass loops
     template <class F>
     int evaluate(F &f, const U *x, const U h);
 
+    // general covector
     template <class F, class CV>
     int evaluate(F &f, const U *x, const U h, CV &&covector);
 
+    // Euclidean covector, exact products J dx by math::dual<U, 1>;
+    // f must also accept (const math::dual<U, 1> *, math::dual<U, 1> *)
+    template <class F>
+    int evaluate_dual(F &f, const U *x, const U h);
+
     void aply(const U *x, U *y) const;
     U spectral_radius_estimate() const;
 
+    // the point x of the last evaluate() and f(x) computed there
+    const std::vector<U> &point() const;
+    const std::vector<U> &f0() const;
+
     void set(size_t size);
 
   protected:
     size_t n;
 
   private:
-    std::vector<U> u[2], v[2], y0, buf[2];
+    std::vector<U> u[2], v[2], y0, x0, buf[3];
     U udotv[4];
 
-    static inline constexpr auto euclid_covector = [](size_t n, const U *x, U *cx)
-    {
-      for (size_t i = 0; i < n; ++i)
-        cx[i] = x[i];
-    };
+    // J ~ sum_k sigma_k v_k u_k^T; the general path normalises u, v and
+    // uses sigma == 1, the fused path keeps u, v unnormalised
+    U sigma[2] = {U(0), U(0)};
+
+    // evaluate_dual() only, sized on first use
+    std::vector<math::dual<U, 1>> x_dual, y_dual;
   };
 
+  // ---------------------------------------------------------------------------
+  //  evaluate (Euclidean covector)
+  // ---------------------------------------------------------------------------
+  //  Same construction as the general evaluate() below with covector(x) = x,
+  //  organised in five sweeps over the n-vectors (besides the calls of f);
+  //  every dot product is accumulated in the sweep that produces its
+  //  operands, and the normalisation of u_k, v_k is kept in sigma_k instead
+  //  of an extra scaling sweep. This moves 28 instead of 65 n-vectors per
+  //  evaluation (see bench_mini_jacobian).
+  // ---------------------------------------------------------------------------
+
   template <class U>
   template <class F>
   inline int mini_jacobian<U>::evaluate(F &f, const U *x, const U h)
   {
-    return evaluate(f, x, h, euclid_covector);
+    using std::sqrt;
+
+    U *xp = buf[0].data();
+    U *xm = buf[1].data();
+    U *dx = buf[2].data();
+    U *u0 = u[0].data();
+    U *v0 = v[0].data();
+    U *u1 = u[1].data();
+    U *v1 = v[1].data();
+
+    stats.count(math::counter::assemblies);
+    stats.count(math::counter::rhs_evaluations, 3);
+
+    // sweep 1: x +- h f(x)
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(x, y0.data());
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = h * y0[i];
+      x0[i] = x[i];
+      xp[i] = x[i] + d;
+      xm[i] = x[i] - d;
+    }
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(xp, v0);
+      f(xm, u0);
+    }
+
+    // sweep 2: odd part v_0, even part w, u_0 = dx and their dot products
+    U *w = xp;
+    U dd = U(0), dv = U(0), dw = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = h * y0[i];
+      const U even = (v0[i] + u0[i]) / 2;
+      const U odd = (v0[i] - u0[i]) / 2;
+      w[i] = even;
+      v0[i] = odd;
+      u0[i] = d;
+      dd += d * d;
+      dv += d * odd;
+      dw += d * even;
+    }
+
+    if (dd == U(0))
+    {
+      sigma[0] = sigma[1] = U(0);
+      return 0;
+    }
+
+    sigma[0] = 1 / dd;
+    const U alpha_v = udotv[0] = sigma[0] * dv;
+    const U alpha_w = sigma[0] * dw;
+
+    // sweep 3: the candidates for the second direction and their norms
+    U aa = U(0), bb = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U a = w[i] - alpha_w * u0[i];
+      const U b = v0[i] - alpha_v * u0[i];
+      u1[i] = a;
+      v1[i] = b;
+      aa += a * a;
+      bb += b * b;
+    }
+    const U *dir = aa > bb ? u1 : v1;
+
+    // sweep 4: x +- h dir
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = h * dir[i];
+      dx[i] = d;
+      xp[i] = x[i] + d;
+      xm[i] = x[i] - d;
+    }
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(xp, v1);
+      f(xm, u1);
+    }
+    stats.count(math::counter::rhs_evaluations, 2);
+
+    // sweep 5: odd part v_1, u_1 = dx and all remaining dot products
+    U dd1 = U(0), dv1 = U(0), u0v1 = U(0), u1v0 = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = dx[i];
+      const U odd = (v1[i] - u1[i]) / 2;
+      v1[i] = odd;
+      u1[i] = d;
+      dd1 += d * d;
+      dv1 += d * odd;
+      u0v1 += u0[i] * odd;
+      u1v0 += d * v0[i];
+    }
+
+    if (dd1 == U(0))
+    {
+      sigma[1] = U(0);
+      return 1;
+    }
+
+    sigma[1] = 1 / dd1;
+    udotv[3] = sigma[1] * dv1;
+    const U s01 = sqrt(sigma[0] * sigma[1]);
+    udotv[1] = s01 * u0v1;
+    udotv[2] = s01 * u1v0;
+
+    return 2;
   }
 
+  // ---------------------------------------------------------------------------
+  //  evaluate (general covector)
+  // ---------------------------------------------------------------------------
+
   template <class U>
   template <class F, class CV>
   inline int mini_jacobian<U>::evaluate(F &f, const U *x, const U h, CV &&covector)
   {
-    f(x, y0.data());
+    stats.count(math::counter::assemblies);
+    stats.count(math::counter::rhs_evaluations);
+    sigma[0] = sigma[1] = U(0);
+    std::copy(x, x + n, x0.begin());
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(x, y0.data());
+    }
 
     auto &dx = buf[0];
     auto &x_push = buf[1];
@@ -61,11 +211,18 @@ namespace rkgl
 
       for (size_t i = 0; i < n; ++i)
         x_push[i] = x[i] + dx[i];
-      f(x_push.data(), pv.data());
+      {
+        auto timer = stats.time(math::phase::rhs);
+        f(x_push.data(), pv.data());
+      }
 
       for (size_t i = 0; i < n; ++i)
         x_push[i] -= 2 * dx[i];
-      f(x_push.data(), pu.data());
+      {
+        auto timer = stats.time(math::phase::rhs);
+        f(x_push.data(), pu.data());
+      }
+      stats.count(math::counter::rhs_evaluations, 2);
 
       auto &pw = x_push;
 
@@ -110,12 +267,14 @@ namespace rkgl
             dx[i] = h * pb[i];
       }
 
-      denom = std::sqrt(denom);
+      using std::sqrt;
+      denom = sqrt(denom);
       for (size_t i = 0; i < n; ++i)
       {
         pu[i] *= denom;
         pv[i] *= denom;
       }
+      sigma[k] = U(1);
     }
 
     udotv[1] = math::dot_product(n, u[0].data(), v[1].data());
@@ -124,10 +283,118 @@ namespace rkgl
     return 2;
   }
 
+  // ---------------------------------------------------------------------------
+  //  evaluate_dual
+  // ---------------------------------------------------------------------------
+  //  The directions of evaluate() with the odd parts (f(x + dx) - f(x - dx)) / 2
+  //  replaced by the exact products J dx. The even part is then f(x) itself,
+  //  whose component orthogonal to dx = h f(x) vanishes, so the second
+  //  direction is always the Krylov vector J dx_0 - alpha dx_0; it depends on
+  //  the first product, hence two dual evaluations with one lane each
+  //  (3 evaluations of f in total instead of 5).
+  // ---------------------------------------------------------------------------
+
+  template <class U>
+  template <class F>
+  inline int mini_jacobian<U>::evaluate_dual(F &f, const U *x, const U h)
+  {
+    using std::sqrt;
+
+    if (x_dual.size() != n)
+    {
+      x_dual.resize(n);
+      y_dual.resize(n);
+    }
+    const math::dual<U, 1> *xd = x_dual.data();
+
+    U *u0 = u[0].data();
+    U *v0 = v[0].data();
+    U *u1 = u[1].data();
+    U *v1 = v[1].data();
+
+    stats.count(math::counter::assemblies);
+    stats.count(math::counter::rhs_evaluations, 2);
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(x, y0.data());
+    }
+
+    // first direction dx = h f(x)
+    U dd = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = h * y0[i];
+      x0[i] = x[i];
+      u0[i] = d;
+      x_dual[i].v = x[i];
+      x_dual[i].d[0] = d;
+      dd += d * d;
+    }
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(xd, y_dual.data());
+    }
+
+    U dv = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      v0[i] = y_dual[i].d[0];
+      dv += u0[i] * v0[i];
+    }
+
+    if (dd == U(0))
+    {
+      sigma[0] = sigma[1] = U(0);
+      return 0;
+    }
+
+    sigma[0] = 1 / dd;
+    const U alpha_v = udotv[0] = sigma[0] * dv;
+
+    // second direction h (J dx - alpha_v dx)
+    U dd1 = U(0), u1v0 = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U d = h * (v0[i] - alpha_v * u0[i]);
+      u1[i] = d;
+      x_dual[i].d[0] = d;
+      dd1 += d * d;
+      u1v0 += d * v0[i];
+    }
+    {
+      auto timer = stats.time(math::phase::rhs);
+      f(xd, y_dual.data());
+    }
+    stats.count(math::counter::rhs_evaluations);
+
+    U dv1 = U(0), u0v1 = U(0);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const U jd = y_dual[i].d[0];
+      v1[i] = jd;
+      dv1 += u1[i] * jd;
+      u0v1 += u0[i] * jd;
+    }
+
+    if (dd1 == U(0))
+    {
+      sigma[1] = U(0);
+      return 1;
+    }
+
+    sigma[1] = 1 / dd1;
+    udotv[3] = sigma[1] * dv1;
+    const U s01 = sqrt(sigma[0] * sigma[1]);
+    udotv[1] = s01 * u0v1;
+    udotv[2] = s01 * u1v0;
+
+    return 2;
+  }
+
   template <class U>
   inline void mini_jacobian<U>::aply(const U x[], U y[]) const
   {
-    U p[2] = {math::dot_product(n, u[0].data(), x), math::dot_product(n, u[1].data(), x)};
+    U p[2] = {sigma[0] * math::dot_product(n, u[0].data(), x), sigma[1] * math::dot_product(n, u[1].data(), x)};
     for (size_t i = 0; i < n; ++i)
       y[i] = p[0] * v[0][i] + p[1] * v[1][i];
   }
@@ -138,6 +405,18 @@ namespace rkgl
     return math::spectral_radius_estimate(2, udotv);
   }
 
+  template <class U>
+  inline const std::vector<U> &mini_jacobian<U>::point() const
+  {
+    return x0;
+  }
+
+  template <class U>
+  inline const std::vector<U> &mini_jacobian<U>::f0() const
+  {
+    return y0;
+  }
+
   template <class U>
   inline void mini_jacobian<U>::set(size_t size)
   {
@@ -148,6 +427,8 @@ namespace rkgl
     v[1].resize(n);
     buf[0].resize(n);
     buf[1].resize(n);
+    buf[2].resize(n);
     y0.resize(n);
+    x0.resize(n);
   }
 }
\ No newline at end of file
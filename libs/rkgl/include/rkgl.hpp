@@ -1,51 +1,104 @@
 #pragma once
 #include <vector>
+#include <cmath>
+#include <algorithm>
 #include <minijacobian.hpp>
+#include <gauss_legendre.hpp>
 
 namespace rkgl
 {
+  // Butcher tables of the Gauss-Legendre methods; row `order` holds the
+  // weights b. Orders 1-3 are written out by hand, all other orders are
+  // generated at compile time by gauss_legendre<U, order>(). Irrational
+  // entries are evaluated in the precision of U.
+
   template <class U, int order>
-  inline const U A[order + 1][order] = {};
+  inline constexpr const U (&A)[order + 1][order] = gauss_legendre_v<U, order>.a;
 
   template <class U>
-  inline const U A<U, 1>[2][1] = {
-      {0.5},
-      {1.0}};
+  inline U rsqrt(const U a)
+  {
+    using std::sqrt;
+    return U(1) / sqrt(a);
+  }
 
-#define rsqrt(a) (1 / std::sqrt(a))
+  template <class U>
+  inline const U A<U, 1>[2][1] = {
+      {U(0.5)},
+      {U(1.0)}};
 
   template <class U>
   inline const U A<U, 2>[3][2] = {
-      {0.25, 0.25 - 0.5 * rsqrt(3.0)},
-      {0.25 + 0.5 * rsqrt(3.0), 0.25},
-      {0.5, 0.5}};
+      {U(0.25), U(0.25) - rsqrt(U(3)) / 2},
+      {U(0.25) + rsqrt(U(3)) / 2, U(0.25)},
+      {U(0.5), U(0.5)}};
 
   template <class U>
   inline const U A<U, 3>[4][3] = {
-      {5.0 / 36.0, 2.0 / 9.0 - rsqrt(15.0), 5.0 / 36.0 - 0.5 * rsqrt(15.0)},
-      {5.0 / 36.0 + 0.625 * rsqrt(15.0), 2.0 / 9.0, 5.0 / 36.0 - 0.625 * rsqrt(15.0)},
-      {5.0 / 36.0 + 0.5 * rsqrt(15.0), 2.0 / 9.0 + rsqrt(15.0), 5.0 / 36.0},
-      {5.0 / 18.0, 4.0 / 9.0, 5.0 / 18.0}};
+      {U(5) / 36, U(2) / 9 - rsqrt(U(15)), U(5) / 36 - rsqrt(U(15)) / 2},
+      {U(5) / 36 + U(0.625) * rsqrt(U(15)), U(2) / 9, U(5) / 36 - U(0.625) * rsqrt(U(15))},
+      {U(5) / 36 + rsqrt(U(15)) / 2, U(2) / 9 + rsqrt(U(15)), U(5) / 36},
+      {U(5) / 18, U(4) / 9, U(5) / 18}};
 
   template <class U, int order>
   class rkgl
   {
   public:
+    int max_iterations = 100;
+    bool predictor = true;
+
+    // sweeps over the stages in the last step and in all steps so far
+    int iterations = 0;
+    size_t total_iterations = 0;
+
+    [[no_unique_address]] math::solver_stats<> stats;
+
     template <class F>
-    void step(F &f, mini_jacobian<U> jac, U *x, const U h, const U tol);
+    void step(F &f, const mini_jacobian<U> &jac, U *x, const U h, const U tol);
+    template <class Vjp>
+    void adjoint_step(Vjp &vjp, const U *x, const U h, U *lambda, const U tol);
+    template <class Vjp, class StageAdjoint>
+    void adjoint_step(Vjp &vjp, StageAdjoint &stage, const U *x, const U h, U *lambda, const U tol);
     void set(size_t size);
 
   private:
     size_t n;
     std::vector<U> k[order], z, y, k_tmp;
+    std::vector<U> y_bar[order], k_pred[order], x_end;
+    U c[order];
+    U h_prev = U(0);
+    bool continued = false;
+
+    void predict(const mini_jacobian<U> &jac, const U *x, const U h);
   };
 
+  // ---------------------------------------------------------------------------
+  //  step
+  // ---------------------------------------------------------------------------
+  //  Solves the stage equations k_j = f(x + h sum_m A_jm k_m) by sweeps over
+  //  the stages. After re-evaluating stage j, its change is propagated to all
+  //  stages through the rank-2 Jacobian `jac` (which must be evaluated near
+  //  x). Sweeps stop when h * max |change of k| <= tol or after
+  //  max_iterations sweeps; then x <- x + h sum_j b_j k_j.
+  //  The initial guess of the stages comes from predict(); the number of
+  //  sweeps is reported in `iterations`.
+  // ---------------------------------------------------------------------------
+
   template <class U, int order>
   template <class F>
-  inline void rkgl<U, order>::step(F &f, mini_jacobian<U> jac, U *x, const U h, const U tol)
+  inline void rkgl<U, order>::step(F &f, const mini_jacobian<U> &jac, U *x, const U h, const U tol)
   {
-    for (int s = 0; s < 100; s++)
+    using std::abs;
+
+    if (predictor)
+      predict(jac, x, h);
+
+    iterations = 0;
+    for (int s = 0; s < max_iterations; s++)
     {
+      U change = U(0);
+      iterations++;
+
       for (int j = 0; j < order; j++)
       {
         for (size_t i = 0; i < n; i++)
@@ -57,10 +110,17 @@ namespace rkgl
         }
 
         k_tmp = k[j];
-        f(z.data(), k[j].data());
+        {
+          auto timer = stats.time(math::phase::rhs);
+          f(z.data(), k[j].data());
+        }
 
         for (size_t i = 0; i < n; i++)
-          k_tmp[i] = h * (k[j][i] - k_tmp[i]) ;
+        {
+          k_tmp[i] = k[j][i] - k_tmp[i];
+          change = std::max(change, abs(k_tmp[i]));
+          k_tmp[i] *= h;
+        }
         jac.aply(k_tmp.data(), k_tmp.data());
 
         for (int m = 0; m < order; m++)
@@ -68,18 +128,192 @@ namespace rkgl
             k[m][i] += k_tmp[i] * A<U, order>[m][j];
       }
 
+      if (abs(h) * change <= tol)
+        break;
+    }
+    total_iterations += iterations;
+    stats.count(math::counter::steps);
+    stats.count(math::counter::iterations, iterations);
+    stats.count(math::counter::rhs_evaluations, size_t(order) * iterations);
 
-
+    for (size_t i = 0; i < n; i++)
+    {
+      U tmp = U(0);
+      for (int j = 0; j < order; j++)
+        tmp += k[j][i] * A<U, order>[order][j];
+      x[i] += h * tmp;
     }
+
+    std::copy(x, x + n, x_end.begin());
+    h_prev = h;
+    continued = true;
   };
 
+  // ---------------------------------------------------------------------------
+  //  predict
+  // ---------------------------------------------------------------------------
+  //  Initial guess of the stages. If x is where the previous step ended, the
+  //  derivative of its collocation polynomial, interpolating k_m at the
+  //  nodes c_m and f(x) at t = 1 (taken from jac.f0() when jac was evaluated
+  //  at x), is extrapolated to the new nodes t = 1 + c_j h / h_prev. With
+  //  f(x) alone every stage starts from f(x); otherwise the previous stage
+  //  values are kept.
+  // ---------------------------------------------------------------------------
+
+  template <class U, int order>
+  inline void rkgl<U, order>::predict(const mini_jacobian<U> &jac, const U *x, const U h)
+  {
+    const bool has_f0 = std::equal(x, x + n, jac.point().begin());
+    const bool has_prev = continued && h_prev != U(0) && std::equal(x, x + n, x_end.begin());
+
+    if (has_prev)
+    {
+      // nodes c_0 .. c_{s-1} and, with f(x), the node 1
+      constexpr int max_nodes = order + 1;
+      const int nodes = has_f0 ? max_nodes : order;
+      U t[max_nodes];
+      for (int m = 0; m < order; m++)
+        t[m] = c[m];
+      t[order] = U(1);
+
+      const U r = h / h_prev;
+      for (int j = 0; j < order; j++)
+      {
+        const U tau = U(1) + c[j] * r;
+        U w[max_nodes];
+        for (int m = 0; m < nodes; m++)
+        {
+          w[m] = U(1);
+          for (int l = 0; l < nodes; l++)
+            if (l != m)
+              w[m] *= (tau - t[l]) / (t[m] - t[l]);
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+          U tmp = has_f0 ? w[order] * jac.f0()[i] : U(0);
+          for (int m = 0; m < order; m++)
+            tmp += w[m] * k[m][i];
+          k_pred[j][i] = tmp;
+        }
+      }
+
+      for (int j = 0; j < order; j++)
+        k[j].swap(k_pred[j]);
+    }
+    else if (has_f0)
+      for (int j = 0; j < order; j++)
+        std::copy(jac.f0().begin(), jac.f0().end(), k[j].begin());
+  }
+
+  // ---------------------------------------------------------------------------
+  //  adjoint_step
+  // ---------------------------------------------------------------------------
+  //  Discrete adjoint of the last step: with lambda = dL/dx_{n+1} on entry,
+  //  lambda <- dL/dx_n on return. Must be called after step() from the same
+  //  x, whose converged stage values k_j it uses.
+  //
+  //  For x_{n+1} = x + h sum_j b_j k_j, k_j = f(Y_j), Y_j = x + h sum_m A_jm k_m
+  //  the stage adjoints Ybar_j = J(Y_j)^T kbar_j satisfy
+  //
+  //      kbar_j = h (b_j lambda + sum_i A_ij Ybar_i),
+  //
+  //  solved by sweeps over the stages as in step(), until
+  //  max |change of Ybar| <= tol; then lambda <- lambda + sum_j Ybar_j.
+  //
+  //  vjp(y, w, out) must set out = J(y)^T w; it is called in every sweep.
+  //  stage(y, kbar) is called once per stage after convergence, so that
+  //  parameter gradients can be accumulated as (df/dtheta(y))^T kbar.
+  // ---------------------------------------------------------------------------
+
+  template <class U, int order>
+  template <class Vjp>
+  inline void rkgl<U, order>::adjoint_step(Vjp &vjp, const U *x, const U h, U *lambda, const U tol)
+  {
+    auto no_parameters = [](const U *, const U *) {};
+    adjoint_step(vjp, no_parameters, x, h, lambda, tol);
+  }
+
+  template <class U, int order>
+  template <class Vjp, class StageAdjoint>
+  inline void rkgl<U, order>::adjoint_step(Vjp &vjp, StageAdjoint &stage, const U *x, const U h, U *lambda, const U tol)
+  {
+    using std::abs;
+
+    for (int j = 0; j < order; j++)
+      std::fill(y_bar[j].begin(), y_bar[j].end(), U(0));
+
+    // z holds Y_j, k_tmp holds kbar_j, y holds the previous kbar_j
+    for (int s = 0; s < max_iterations; s++)
+    {
+      U change = U(0);
+
+      for (int j = 0; j < order; j++)
+      {
+        for (size_t i = 0; i < n; i++)
+        {
+          U tmp = U(0);
+          for (int m = 0; m < order; m++)
+            tmp += k[m][i] * A<U, order>[j][m];
+          z[i] = x[i] + h * tmp;
+
+          U bar = A<U, order>[order][j] * lambda[i];
+          for (int m = 0; m < order; m++)
+            bar += A<U, order>[m][j] * y_bar[m][i];
+          k_tmp[i] = h * bar;
+        }
+
+        y = y_bar[j];
+        vjp(static_cast<const U *>(z.data()), static_cast<const U *>(k_tmp.data()), y_bar[j].data());
+
+        for (size_t i = 0; i < n; i++)
+          change = std::max(change, abs(y_bar[j][i] - y[i]));
+      }
+
+      if (change <= tol)
+        break;
+    }
+
+    for (int j = 0; j < order; j++)
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        U tmp = U(0);
+        U bar = A<U, order>[order][j] * lambda[i];
+        for (int m = 0; m < order; m++)
+        {
+          tmp += k[m][i] * A<U, order>[j][m];
+          bar += A<U, order>[m][j] * y_bar[m][i];
+        }
+        z[i] = x[i] + h * tmp;
+        k_tmp[i] = h * bar;
+      }
+      stage(static_cast<const U *>(z.data()), static_cast<const U *>(k_tmp.data()));
+    }
+
+    for (int j = 0; j < order; j++)
+      for (size_t i = 0; i < n; i++)
+        lambda[i] += y_bar[j][i];
+  }
+
   template <class U, int order>
   inline void rkgl<U, order>::set(size_t size)
   {
     n = size;
     for (int j = 0; j < order; j++)
+    {
       k[j].resize(n, U(0));
+      y_bar[j].resize(n, U(0));
+      k_pred[j].resize(n, U(0));
+
+      c[j] = U(0);
+      for (int m = 0; m < order; m++)
+        c[j] += A<U, order>[j][m];
+    }
+    x_end.resize(n, U(0));
+    continued = false;
     y.resize(n, U(0));
     z.resize(n, U(0));
+    k_tmp.resize(n, U(0));
   }
 }
@@ -1,6 +1,17 @@
 #pragma once
 #include <utest_frame.hpp>
 #include <ling.hpp>
+#include <checkpoint.hpp>
+#include <dual.hpp>
+#include <stats.hpp>
+#include <thread_pool.hpp>
+#include <parareal.hpp>
+#include <kernel_config.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <sstream>
+#include <type_traits>
+#include <vector>
 #include <string>
 
 template<class U>
@@ -87,6 +98,29 @@ void test_solve_opt(utest::error_accumulator &ea)
   ea.throw_if_any();
 }
 
+void test_lu_blocked(utest::error_accumulator &ea)
+{
+  for (const size_t n : {5, 33, 70})
+  {
+    std::vector<double> A(n * n), B;
+    QuasiRandom qr;
+    for (size_t i = 0; i < n * n; ++i)
+      A[i] = 0.1 * qr.next();
+    for (size_t i = 0; i < n; ++i)
+      A[n * i + i] += 1.0;
+    B = A;
+
+    math::lu_naive(n, A.data());
+    math::lu_blocked(n, B.data(), 16);
+
+    size_t differing = 0;
+    for (size_t i = 0; i < n * n; ++i)
+      differing += A[i] != B[i];
+    if (differing > 0)
+      ea << "lu_blocked differs from lu_naive in " + std::to_string(differing) + " entries for n = " + std::to_string(n);
+  }
+}
+
 void test_remove_tangent_components(utest::error_accumulator &ea)
 {
   double u[2][3] = {
@@ -103,4 +137,356 @@ void test_remove_tangent_components(utest::error_accumulator &ea)
   ea << utest::compare_numeric("wrong remove_tangent_component 0", 0.0, x[0]);
   ea << utest::compare_numeric("wrong remove_tangent_component 1", rem, x[1]);
   ea << utest::compare_numeric("wrong remove_tangent_component 2", rem, x[2]);
-}
\ No newline at end of file
+}
+
+void test_solve_refined(utest::error_accumulator &ea)
+{
+  constexpr size_t n = 20;
+  double A[n * n], x[n], y[n], rhs[n];
+  float lu[n * n], d[n];
+
+  QuasiRandom qr;
+
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = 0.1 * qr.next();
+  for (size_t i = 0; i < n; ++i)
+  {
+    x[i] = y[i] = qr.next();
+    A[n * i + i] += 1.0;
+  }
+
+  math::solve_refined(n, A, x, lu, d, rhs, 3);
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    double sum = math::dot_product(n, A + n * i, x);
+    ea << utest::compare_numeric("wrong solve_refined<float, double>", y[i], sum, 4 * eps<double> * n);
+  }
+}
+
+void test_expm_pade(utest::error_accumulator &ea)
+{
+  // exp of t * [[0, 1], [-1, 0]] is the rotation by t; t = 5 needs squarings
+  const double t = 5.0;
+  double A[4] = {0.0, t, -t, 0.0};
+  double work[16];
+
+  math::expm_pade(2, A, work);
+
+  ea << utest::compare_numeric("wrong expm_pade 00", std::cos(t), A[0], 1e-13);
+  ea << utest::compare_numeric("wrong expm_pade 01", std::sin(t), A[1], 1e-13);
+  ea << utest::compare_numeric("wrong expm_pade 10", -std::sin(t), A[2], 1e-13);
+  ea << utest::compare_numeric("wrong expm_pade 11", std::cos(t), A[3], 1e-13);
+
+  // exp of a nilpotent matrix is a finite sum
+  double N[9] = {0.0, 2.0, 3.0,
+                 0.0, 0.0, 4.0,
+                 0.0, 0.0, 0.0};
+  double work3[36];
+  math::expm_pade(3, N, work3);
+  ea << utest::compare_numeric("wrong expm_pade of nilpotent", 3.0 + 2.0 * 4.0 / 2, N[2], 1e-15);
+}
+
+void test_fb_multi(utest::error_accumulator &ea)
+{
+  constexpr size_t n = 12, m = 5;
+  double A[n * n], LU[n * n], V[n * m], X[n * m];
+
+  QuasiRandom qr;
+
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = 0.1 * qr.next();
+  for (size_t i = 0; i < n; ++i)
+    A[n * i + i] += 1.0;
+  for (size_t i = 0; i < n * m; ++i)
+    V[i] = X[i] = qr.next();
+
+  std::copy(A, A + n * n, LU);
+  math::lu_naive(n, LU);
+  math::fb_multi(n, m, LU, X);
+
+  for (size_t r = 0; r < m; ++r)
+    for (size_t i = 0; i < n; ++i)
+    {
+      double sum = 0.0;
+      for (size_t k = 0; k < n; ++k)
+        sum += A[n * i + k] * X[m * k + r];
+      ea << utest::compare_numeric("wrong fb_multi", V[m * i + r], sum, 4 * eps<double> * n);
+    }
+}
+
+void test_fb_transposed(utest::error_accumulator &ea)
+{
+  constexpr size_t n = 15;
+  double A[n * n], LU[n * n], x[n], y[n];
+
+  QuasiRandom qr;
+
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = 0.1 * qr.next();
+  for (size_t i = 0; i < n; ++i)
+  {
+    A[n * i + i] += 1.0;
+    x[i] = y[i] = qr.next();
+  }
+
+  std::copy(A, A + n * n, LU);
+  math::lu_naive(n, LU);
+  math::fb_transposed(n, LU, x);
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    double sum = 0.0;
+    for (size_t k = 0; k < n; ++k)
+      sum += A[n * k + i] * x[k];
+    ea << utest::compare_numeric("wrong fb_transposed", y[i], sum, 4 * eps<double> * n);
+  }
+}
+
+void test_bisection_reverse(utest::error_accumulator &ea)
+{
+  // the state is the step index itself
+  const size_t steps = 1000;
+  std::vector<size_t> visited;
+
+  auto forward = [](size_t &x, size_t)
+  { ++x; };
+  auto backward = [&](const size_t &x, size_t i)
+  {
+    if (x != i)
+      ea << "bisection_reverse passed a wrong state";
+    visited.push_back(i);
+  };
+
+  const math::checkpoint_stats stats = math::bisection_reverse(steps, size_t(0), forward, backward);
+
+  bool order = visited.size() == steps;
+  for (size_t k = 0; order && k < steps; ++k)
+    order = visited[k] == steps - 1 - k;
+  if (!order)
+    ea << "bisection_reverse does not visit the steps in reverse order";
+  if (stats.peak_states > 11)
+    ea << "bisection_reverse keeps more than log2(N) + 1 states";
+  if (stats.forward_steps > steps * 6)
+    ea << "bisection_reverse recomputes more than log2(N) / 2 times";
+}
+
+void test_binomial_reverse(utest::error_accumulator &ea)
+{
+  auto forward = [](size_t &x, size_t)
+  { ++x; };
+
+  // forward steps of revolve, r N - beta(c + 1, r - 1)
+  const size_t cases[][3] = {{1000, 10, 3636}, {1000, 3, 12155}, {100, 5, 316}, {64, 7, 147}, {37, 1, 666}, {1, 4, 0}};
+  for (const auto &[steps, snapshots, expected] : cases)
+  {
+    const std::string name = "N = " + std::to_string(steps) + ", c = " + std::to_string(snapshots);
+    std::vector<size_t> visited;
+    auto backward = [&](const size_t &x, size_t i)
+    {
+      if (x != i)
+        ea << "binomial_reverse passed a wrong state (" + name + ")";
+      visited.push_back(i);
+    };
+
+    const math::checkpoint_stats stats = math::binomial_reverse(steps, snapshots, size_t(0), forward, backward);
+
+    bool order = visited.size() == steps;
+    for (size_t k = 0; order && k < steps; ++k)
+      order = visited[k] == steps - 1 - k;
+    if (!order)
+      ea << "binomial_reverse does not visit the steps in reverse order (" + name + ")";
+    if (stats.peak_states > snapshots + 1)
+      ea << "binomial_reverse keeps more than snapshots + 1 states (" + name + ")";
+    ea << utest::compare_numeric("wrong forward steps of binomial_reverse (" + name + ")", double(expected), double(stats.forward_steps));
+    ea << utest::compare_numeric("wrong binomial_forward_steps (" + name + ")", double(expected), double(math::binomial_forward_steps(steps, snapshots)));
+  }
+
+  // never more recomputation than bisection with the same memory
+  auto ignore = [](const size_t &, size_t) {};
+  const size_t steps = 1000;
+  const math::checkpoint_stats bisection = math::bisection_reverse(steps, size_t(0), forward, ignore);
+  const math::checkpoint_stats binomial = math::binomial_reverse(steps, math::bisection_snapshots(steps), size_t(0), forward, ignore);
+  if (binomial.peak_states > bisection.peak_states || binomial.forward_steps >= bisection.forward_steps)
+    ea << "binomial_reverse does not improve on bisection_reverse";
+}
+
+void test_dual_jvp(utest::error_accumulator &ea)
+{
+  // y0 = x0 x1 / x2 + sin(x0), y1 = exp(x1) sqrt(x2) - log(x0), y2 = 2 x2 - 3 abs(x1)
+  auto f = [](const auto *x, auto *y)
+  {
+    y[0] = x[0] * x[1] / x[2] + sin(x[0]);
+    y[1] = exp(x[1]) * sqrt(x[2]) - log(x[0]);
+    y[2] = 2 * x[2] - 3.0 * abs(x[1]);
+  };
+
+  const double x[3] = {0.7, -0.4, 1.9};
+  const double J[3][3] = {{x[1] / x[2] + std::cos(x[0]), x[0] / x[2], -x[0] * x[1] / (x[2] * x[2])},
+                          {-1 / x[0], std::exp(x[1]) * std::sqrt(x[2]), std::exp(x[1]) / (2 * std::sqrt(x[2]))},
+                          {0.0, 3.0, 2.0}};
+
+  // lanes: e_0, e_1, e_2 and (1, -2, 0.5); row-major 3 x 4
+  const double dirs[12] = {1.0, 0.0, 0.0, 1.0,
+                           0.0, 1.0, 0.0, -2.0,
+                           0.0, 0.0, 1.0, 0.5};
+  double y[3], jv[12];
+  math::jvp<4>(f, 3, x, dirs, y, jv);
+
+  auto fd = [](const double *x, double *y)
+  {
+    y[0] = x[0] * x[1] / x[2] + std::sin(x[0]);
+    y[1] = std::exp(x[1]) * std::sqrt(x[2]) - std::log(x[0]);
+    y[2] = 2 * x[2] - 3.0 * std::abs(x[1]);
+  };
+  double y_ref[3];
+  fd(x, y_ref);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    ea << utest::compare_numeric("wrong dual value " + std::to_string(i), y_ref[i], y[i], 1e-15);
+    for (size_t k = 0; k < 4; ++k)
+    {
+      double expected = 0.0;
+      for (size_t j = 0; j < 3; ++j)
+        expected += J[i][j] * dirs[4 * j + k];
+      ea << utest::compare_numeric("wrong dual jvp (" + std::to_string(i) + ", " + std::to_string(k) + ")", expected, jv[4 * i + k], 1e-14);
+    }
+  }
+}
+
+void test_solver_stats(utest::error_accumulator &ea)
+{
+  if (!std::is_empty_v<math::solver_stats<0>>)
+    ea << "solver_stats<0> is not empty";
+
+  math::solver_stats<0> off;
+  off.count(math::counter::steps);
+  {
+    auto timer = off.time(math::phase::assemble);
+  }
+  ea << utest::compare_numeric("solver_stats<0> counts", 0.0, double(off.get(math::counter::steps)));
+
+  math::solver_stats<2> on;
+  on.count(math::counter::steps);
+  on.count(math::counter::rhs_evaluations, 5);
+  {
+    auto timer = on.time(math::phase::rhs);
+    volatile double sink = 0.0;
+    for (int i = 0; i < 1000; ++i)
+      sink = sink + std::sqrt(double(i));
+  }
+  ea << utest::compare_numeric("wrong solver_stats steps", 1.0, double(on.get(math::counter::steps)));
+  ea << utest::compare_numeric("wrong solver_stats rhs_evaluations", 5.0, double(on.get(math::counter::rhs_evaluations)));
+  if (!(on.seconds(math::phase::rhs) > 0.0) || on.seconds(math::phase::assemble) != 0.0)
+    ea << "wrong solver_stats phase times";
+
+  std::ostringstream json;
+  on.write_json(json);
+  const std::string s = json.str();
+  if (s.rfind("{\"level\":2,\"counters\":{\"steps\":1,\"rejected_steps\":0,\"rhs_evaluations\":5,", 0) != 0 || s.find("\"seconds\":{\"assemble\":0,") == std::string::npos || s.back() != '}')
+    ea << "unexpected solver_stats JSON: " + s;
+
+  on.reset();
+  ea << utest::compare_numeric("solver_stats reset", 0.0, double(on.get(math::counter::rhs_evaluations)));
+}
+
+void test_thread_pool(utest::error_accumulator &ea)
+{
+  math::thread_pool pool(4);
+  ea << utest::compare_numeric("wrong thread_pool size", 4.0, double(pool.size()));
+
+  for (const size_t count : {0, 1, 3, 1000})
+  {
+    std::vector<int> hits(count, 0);
+    pool.parallel_for(count, [&](const size_t i)
+                      { hits[i]++; });
+    if (std::count(hits.begin(), hits.end(), 1) != std::ptrdiff_t(count))
+      ea << "parallel_for did not call every index once for count " + std::to_string(count);
+  }
+
+  std::atomic<int> calls{0};
+  try
+  {
+    pool.parallel_for(100, [&](const size_t i)
+                      {
+                        calls++;
+                        if (i == 7)
+                          throw std::runtime_error("index 7"); });
+    ea << "parallel_for did not rethrow";
+  }
+  catch (const std::runtime_error &)
+  {
+  }
+  ea << utest::compare_numeric("parallel_for stopped after an exception", 100.0, double(calls.load()));
+}
+
+void test_parareal(utest::error_accumulator &ea)
+{
+  // harmonic oscillator over 16 slices of length 0.5: one explicit midpoint
+  // step as G, the exact rotation as F
+  const size_t slices = 16;
+  const double dt = 0.5;
+  auto coarse = [&](size_t, double *x)
+  {
+    const double p = x[0] + dt / 2 * x[1], q = x[1] - dt / 2 * x[0];
+    x[0] += dt * q;
+    x[1] -= dt * p;
+  };
+  auto fine = [&](size_t, double *x)
+  {
+    const double c = std::cos(dt), s = std::sin(dt);
+    const double p = c * x[0] + s * x[1], q = -s * x[0] + c * x[1];
+    x[0] = p;
+    x[1] = q;
+  };
+
+  math::thread_pool pool(3);
+  std::vector<double> U(2 * (slices + 1));
+  U[0] = 1.0;
+  U[1] = 0.0;
+  const auto st = math::parareal(pool, 2, slices, U.data(), coarse, fine, 1e-12, slices);
+
+  if (!st.converged || st.iterations >= slices)
+    ea << "parareal did not converge before the serial limit";
+  if (st.updates.size() != st.iterations || !(st.updates.back() <= 1e-12))
+    ea << "wrong parareal update history";
+  const double t = dt * slices;
+  ea << utest::compare_numeric("wrong parareal end state x[0]", std::cos(t), U[2 * slices], 1e-11);
+  ea << utest::compare_numeric("wrong parareal end state x[1]", -std::sin(t), U[2 * slices + 1], 1e-11);
+
+  // with tol = 0 every slice gets its fine solve: the serial fine result
+  std::fill(U.begin() + 2, U.end(), 0.0);
+  const auto serial = math::parareal(pool, 2, slices, U.data(), coarse, fine, 0.0, slices);
+  double x[2] = {1.0, 0.0};
+  for (size_t k = 0; k < slices; ++k)
+    fine(k, x);
+  ea << utest::compare_numeric("wrong parareal iteration count at tol 0", double(slices), double(serial.iterations));
+  ea << utest::compare_numeric("parareal differs from the serial fine solution", x[0], U[2 * slices]);
+}
+
+void test_kernel_config(utest::error_accumulator &ea)
+{
+  const math::kernel_thresholds defaults = math::kernel_thresholds_for<double>();
+
+  std::istringstream in("# type fixed_max blocked_min block\n"
+                        "double 6 48 16\n"
+                        "float 40 8 64\n"
+                        "quad 1 2 3\n"
+                        "double_double broken\n");
+  ea << utest::compare_numeric("wrong number of applied kernel thresholds", 2.0, double(math::load_kernel_config(in)));
+
+  const math::kernel_thresholds &d = math::kernel_thresholds_for<double>();
+  const math::kernel_thresholds &f = math::kernel_thresholds_for<float>();
+  ea << utest::compare_numeric("wrong double fixed_max", 6.0, double(d.fixed_max));
+  ea << utest::compare_numeric("wrong double blocked_min", 48.0, double(d.blocked_min));
+  ea << utest::compare_numeric("wrong double block", 16.0, double(d.block));
+  ea << utest::compare_numeric("float fixed_max not clamped", 16.0, double(f.fixed_max));
+  ea << utest::compare_numeric("float blocked_min not raised above fixed_max", 17.0, double(f.blocked_min));
+
+  std::ostringstream out;
+  math::write_kernel_config<double>(out, defaults);
+  std::istringstream restore(out.str() + "float 16 17 32\n");
+  math::load_kernel_config(restore);
+  ea << utest::compare_numeric("kernel thresholds not restored", double(defaults.blocked_min), double(math::kernel_thresholds_for<double>().blocked_min));
+}
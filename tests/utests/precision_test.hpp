@@ -0,0 +1,223 @@
+#pragma once
+#include <utest_frame.hpp>
+#include <ling_test.hpp>
+#include <ling.hpp>
+#include <double_double.hpp>
+#include <qode1.hpp>
+#include <rkgl.hpp>
+#include <minijacobian.hpp>
+#include <string>
+#include <typeinfo>
+
+// The templates are exercised with float, double, long double and
+// math::double_double. Differences are converted to double after they are
+// formed in U, so that no precision of U is lost in the comparison.
+
+template <class U>
+std::string precision_name()
+{
+  if constexpr (std::is_same_v<U, float>)
+    return "float";
+  else if constexpr (std::is_same_v<U, double>)
+    return "double";
+  else if constexpr (std::is_same_v<U, long double>)
+    return "long double";
+  else
+    return "double_double";
+}
+
+template <class U>
+std::string compare_precision(const std::string &msg, const U expected, const U actual, const U tol)
+{
+  using std::abs;
+  if (abs(expected - actual) > tol)
+    return utest::compare_numeric(msg + " [" + precision_name<U>() + "]", 0.0, double(actual - expected));
+  return "";
+}
+
+template <class U>
+class Lotka_Voltera_precision : public qode::qode1_core<U>
+{
+public:
+  Lotka_Voltera_precision() : qode::qode1_core<U>(2) {};
+
+  void set_coef() override
+  {
+    this->b_coef(0, 0) = U(2) / 3;
+    this->b_coef(1, 1) = U(-1);
+
+    this->c_coef(0, 0, 1) = U(-4) / 3;
+    this->c_coef(1, 0, 1) = U(1);
+  }
+};
+
+template <size_t n, class U>
+void subtest_solve_opt_precision(utest::error_accumulator &ea)
+{
+  U A[n * n], B[n * n];
+  U x[n], y[n];
+
+  QuasiRandom qr;
+
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = B[i] = U(0.1) * U(qr.next());
+  for (size_t i = 0; i < n; ++i)
+  {
+    x[i] = y[i] = U(qr.next());
+    A[n * i + i] += 1;
+    B[n * i + i] += 1;
+  }
+
+  math::solve_opt<n>(A, x);
+
+  for (size_t i = 0; i < n; ++i)
+    ea << compare_precision("wrong solve_opt<" + std::to_string(n) + ">", y[i], math::dot_product(n, B + n * i, x), eps<U> * 4 * U(n));
+}
+
+template <class U>
+void subtest_qode1_precision(utest::error_accumulator &ea)
+{
+  if constexpr (std::is_same_v<U, math::double_double>)
+  {
+    // no wider reference type: every step must solve its defining equation
+    //   x' = x + h (B (x + x') / 2 + C (x x' + x' x) / 2)
+    // to the precision of U (a double solve would leave ~1e-17)
+    Lotka_Voltera_precision<U> core;
+    core.x = {U(1), U(1)};
+    const U h = U(1) / 20;
+    for (int i = 0; i < 100; ++i)
+    {
+      const U x = core.x[0], y = core.x[1];
+      core.step(h);
+      const U xn = core.x[0], yn = core.x[1];
+      const U cross = (x * yn + xn * y) / 2;
+      const U r[2] = {xn - x - h * (U(2) / 3 * (x + xn) / 2 + U(-4) / 3 * cross),
+                      yn - y - h * (-(y + yn) / 2 + cross)};
+      for (size_t k = 0; k < 2; ++k)
+        ea << compare_precision("qode1_core step " + std::to_string(i) + " does not solve its equation x[" + std::to_string(k) + "]",
+                                U(0), r[k], eps<U> * 64);
+    }
+  }
+  else
+  {
+    Lotka_Voltera_precision<U> core;
+    Lotka_Voltera_precision<math::double_double> ref;
+
+    core.x = {U(1), U(1)};
+    ref.x = {1.0, 1.0};
+
+    for (int i = 0; i < 100; ++i)
+    {
+      core.step(U(1) / 20);
+      ref.step(math::double_double(1.0) / 20);
+    }
+
+    for (size_t i = 0; i < 2; ++i)
+      ea << compare_precision("wrong qode1_core state x[" + std::to_string(i) + "]",
+                              U(double(ref.x[i])) + U(double(ref.x[i] - math::double_double(double(ref.x[i])))),
+                              core.x[i], eps<U> * 2000);
+  }
+}
+
+template <class U, int order>
+void subtest_rkgl_table_precision(utest::error_accumulator &ea)
+{
+  const auto &a = rkgl::A<U, order>;
+  U c[order];
+
+  for (int i = 0; i < order; ++i)
+  {
+    c[i] = U(0);
+    for (int j = 0; j < order; ++j)
+      c[i] += a[i][j];
+  }
+
+  const std::string name = "rkgl::A<" + std::to_string(order) + ">";
+
+  // B(2s): sum_j b_j c_j^(k-1) = 1/k
+  for (int k = 1; k <= 2 * order; ++k)
+  {
+    U sum = U(0);
+    for (int j = 0; j < order; ++j)
+    {
+      U p = U(1);
+      for (int m = 1; m < k; ++m)
+        p *= c[j];
+      sum += a[order][j] * p;
+    }
+    ea << compare_precision("quadrature condition B(" + std::to_string(k) + ") of " + name, U(1) / k, sum, eps<U> * 16);
+  }
+
+  // C(s): sum_j a_ij c_j^(k-1) = c_i^k / k
+  for (int k = 1; k <= order; ++k)
+    for (int i = 0; i < order; ++i)
+    {
+      U sum = U(0), ci = U(1);
+      for (int j = 0; j < order; ++j)
+      {
+        U p = U(1);
+        for (int m = 1; m < k; ++m)
+          p *= c[j];
+        sum += a[i][j] * p;
+      }
+      for (int m = 0; m < k; ++m)
+        ci *= c[i];
+      ea << compare_precision("simplifying condition C(" + std::to_string(k) + ") of " + name, ci / k, sum, eps<U> * 16);
+    }
+}
+
+template <class U>
+void subtest_mini_jacobian_precision(utest::error_accumulator &ea)
+{
+  const U J[4] = {U(0.3), U(1.2), U(-0.7), U(-0.4)};
+
+  auto f = [&J](const U *x, U *y)
+  {
+    y[0] = J[0] * x[0] + J[1] * x[1];
+    y[1] = J[2] * x[0] + J[3] * x[1];
+  };
+
+  rkgl::mini_jacobian<U> mj;
+  mj.set(2);
+
+  const U x[2] = {U(1), U(0.5)};
+  mj.evaluate(f, x, U(0.1));
+
+  const U v[2] = {U(0.25), U(-2)};
+  U y[2], y_ref[2];
+  mj.aply(v, y);
+  f(v, y_ref);
+
+  for (size_t i = 0; i < 2; ++i)
+    ea << compare_precision("wrong mini_jacobian::aply[" + std::to_string(i) + "]", y_ref[i], y[i], eps<U> * 256);
+}
+
+template <class U>
+void subtest_precision(utest::error_accumulator &ea)
+{
+  subtest_solve_opt_precision<3, U>(ea);
+  subtest_solve_opt_precision<6, U>(ea);
+  subtest_solve_opt_precision<9, U>(ea);
+  subtest_qode1_precision<U>(ea);
+  subtest_rkgl_table_precision<U, 1>(ea);
+  subtest_rkgl_table_precision<U, 2>(ea);
+  subtest_rkgl_table_precision<U, 3>(ea);
+  subtest_rkgl_table_precision<U, 5>(ea);
+  subtest_rkgl_table_precision<U, 8>(ea);
+  subtest_mini_jacobian_precision<U>(ea);
+}
+
+void test_precision_float(utest::error_accumulator &ea)
+{
+  subtest_precision<float>(ea);
+}
+
+void test_precision_long_double(utest::error_accumulator &ea)
+{
+  subtest_precision<long double>(ea);
+}
+
+void test_precision_double_double(utest::error_accumulator &ea)
+{
+  subtest_precision<math::double_double>(ea);
+}
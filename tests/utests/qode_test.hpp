@@ -0,0 +1,1098 @@
+#pragma once
+#include <utest_frame.hpp>
+#include <qode1.hpp>
+#include <qode1_static.hpp>
+#include <qode1_model.hpp>
+#include <composition.hpp>
+#include <step_control.hpp>
+#include <verlet.hpp>
+#include <ricatti.hpp>
+#include <lyapunov.hpp>
+#include <sensitivity.hpp>
+#include <adjoint.hpp>
+#include <qode1_file.hpp>
+#include <trajectory.hpp>
+#include <steady_state.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+class Lotka_Voltera : public qode::qode1_core<double>
+{
+public:
+  Lotka_Voltera() : qode::qode1_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+using lotka_volterra_model = qode::static_model<2,
+                                                qode::b_term<0, 0, 2.0 / 3.0>,
+                                                qode::b_term<1, 1, -1.0>,
+                                                qode::c_term<0, 0, 1, -4.0 / 3.0>,
+                                                qode::c_term<1, 0, 1, 1.0>>;
+
+void test_qode1_static(utest::error_accumulator &ea)
+{
+  Lotka_Voltera dyn;
+  qode::qode1_static<double, lotka_volterra_model> fix;
+
+  dyn.x = {1.0, 1.0};
+  fix.x = {1.0, 1.0};
+
+  const double mu = 0.03;
+  double h_dyn = dyn.suggest_first_stepsize(1.0, mu);
+  double h_fix = fix.suggest_first_stepsize(1.0, mu);
+  ea << utest::compare_numeric("wrong suggest_first_stepsize", h_dyn, h_fix, 1e-15);
+
+  for (int i = 0; i < 200; ++i)
+  {
+    dyn.step_adaptive(h_dyn, mu);
+    fix.step_adaptive(h_fix, mu);
+  }
+
+  ea << utest::compare_numeric("wrong stepsize after step_adaptive", h_dyn, h_fix, 1e-12);
+  for (size_t i = 0; i < 2; ++i)
+    ea << utest::compare_numeric("wrong state x[" + std::to_string(i) + "] after step_adaptive", dyn.x[i], fix.x[i], 1e-12);
+
+  using accumulating_model = qode::static_model<3,
+                                                qode::a_term<0, 0.5>,
+                                                qode::a_term<0, 0.25>,
+                                                qode::b_term<1, 2, -1.0>,
+                                                qode::c_term<2, 1, 1, 0.5>,
+                                                qode::c_term<2, 1, 1, 0.5>>;
+  qode::qode1_static<double, accumulating_model> acc;
+  acc.x = {0.0, 1.0, 2.0};
+  acc.step(0.1);
+
+  // x0 += h * 0.75; x1 and x2 follow the symmetric update of the B and C terms
+  ea << utest::compare_numeric("wrong accumulated a_term", 0.075, acc.x[0], 1e-15);
+  const double x1 = 1.0, x2 = 2.0, h = 0.1;
+  // (1 + h^2 x1') x2' = ... solved by hand: x1' = x1 - h (x2 + x2') / 2, x2' = x2 + h x1 x1'
+  const double x2_new = (x2 + h * x1 * (x1 - h * x2 / 2)) / (1 + h * h * x1 / 2);
+  const double x1_new = x1 - h * (x2 + x2_new) / 2;
+  ea << utest::compare_numeric("wrong symmetric B update", x1_new, acc.x[1], 1e-15);
+  ea << utest::compare_numeric("wrong symmetric C update", x2_new, acc.x[2], 1e-15);
+}
+
+void test_qode1_instance(utest::error_accumulator &ea)
+{
+  auto model = std::make_shared<qode::qode1_model<double>>(2, 4);
+  model->b_param(0, 0, 0);
+  model->b_param(1, 1, 1);
+  model->c_param(0, 0, 1, 2);
+  model->c_param(1, 0, 1, 3);
+
+  Lotka_Voltera core;
+  qode::qode1_instance<double> run(model), other(model);
+
+  core.x = {1.0, 1.0};
+  run.x = {1.0, 1.0};
+  other.x = {1.0, 1.0};
+  run.theta = {2.0 / 3.0, -1.0, -4.0 / 3.0, 1.0};
+  other.theta = {1.0, -1.0, -1.0, 1.0};
+
+  const double mu = 0.03;
+  double h_core = core.suggest_first_stepsize(1.0, mu);
+  double h_run = run.suggest_first_stepsize(1.0, mu);
+  double h_other = other.suggest_first_stepsize(1.0, mu);
+
+  for (int i = 0; i < 200; ++i)
+  {
+    core.step_adaptive(h_core, mu);
+    other.step_adaptive(h_other, mu);
+    run.step_adaptive(h_run, mu);
+  }
+
+  ea << utest::compare_numeric("wrong stepsize of parameterized instance", h_core, h_run);
+  for (size_t i = 0; i < 2; ++i)
+    ea << utest::compare_numeric("wrong state x[" + std::to_string(i) + "] of parameterized instance", core.x[i], run.x[i]);
+
+  if (std::abs(other.x[0] - run.x[0]) < 1e-3)
+    ea << "instances sharing a model did not keep their own parameters";
+
+  auto constant = std::make_shared<qode::qode1_model<double>>(1, 1);
+  constant->a_coef(0, 1.0);
+  constant->a_param(0, 0, 2.0);
+  qode::qode1_instance<double> shift(constant);
+  shift.theta = {0.25};
+  shift.step(0.1);
+  ea << utest::compare_numeric("wrong constant plus parameterized a_coef", 0.15, shift.x[0], 1e-16);
+}
+
+class Lotka_Voltera_mixed : public qode::qode1_core<double, float>
+{
+public:
+  Lotka_Voltera_mixed() : qode::qode1_core<double, float>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+void test_qode1_mixed_precision(utest::error_accumulator &ea)
+{
+  Lotka_Voltera core;
+  Lotka_Voltera_mixed mixed;
+
+  core.x = {1.0, 1.0};
+  mixed.x = {1.0, 1.0};
+
+  for (int i = 0; i < 200; ++i)
+  {
+    core.step(0.05);
+    mixed.step(0.05);
+  }
+
+  for (size_t i = 0; i < 2; ++i)
+    ea << utest::compare_numeric("wrong refined state x[" + std::to_string(i) + "]", core.x[i], mixed.x[i], 1e-13);
+}
+
+class Stiff_chain : public qode::qode1_core<double>
+{
+public:
+  double stiffness = 200.0, c = 0.3;
+
+  explicit Stiff_chain(const size_t size) : qode::qode1_core<double>(size) {};
+
+  void set_coef() override
+  {
+    const size_t n = dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      a_coef(i) = 0.5;
+      b_coef(i, i) = -stiffness * double(i + 1);
+      b_coef(i, (i + 1) % n) = 10.0;
+      c_coef(i, i, (i + 2) % n) = c;
+    }
+  }
+};
+
+void test_qode1_imex(utest::error_accumulator &ea)
+{
+  const size_t n = 6;
+  const double t_end = 0.5;
+
+  auto imex_error = [&](const double stiffness, const int steps)
+  {
+    Stiff_chain ref(n), imex(n);
+    ref.stiffness = imex.stiffness = stiffness;
+    imex.set_imex(true);
+    ref.x.assign(n, 1.0);
+    imex.x.assign(n, 1.0);
+    for (int i = 0; i < 20000; ++i)
+      ref.step(t_end / 20000);
+    for (int i = 0; i < steps; ++i)
+      imex.step(t_end / steps);
+
+    double err = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      err = std::max(err, std::abs(imex.x[i] - ref.x[i]));
+    return err;
+  };
+
+  ea << utest::compare_numeric("wrong observed order of the IMEX step", 2.0, std::log2(imex_error(2.0, 40) / imex_error(2.0, 80)), 0.2);
+
+  // h = 0.01 is far beyond the explicit stability limit 2 / 1200
+  if (!(imex_error(200.0, 50) < 1e-2))
+    ea << "IMEX step did not follow the stiff chain";
+
+  // without C terms the IMEX step is the implicit step
+  Stiff_chain plain(n), imex(n);
+  plain.c = imex.c = 0.0;
+  imex.set_imex(true);
+  plain.x.assign(n, 1.0);
+  imex.x.assign(n, 1.0);
+  for (int i = 0; i < 10; ++i)
+  {
+    plain.step(0.01);
+    imex.step(0.01);
+  }
+  for (size_t i = 0; i < n; ++i)
+    ea << utest::compare_numeric("wrong linear IMEX state x[" + std::to_string(i) + "]", plain.x[i], imex.x[i], 1e-14);
+}
+
+void test_qode1_file(utest::error_accumulator &ea)
+{
+  qode::qode1_coefficients<double> lv(2);
+  lv.b_coef(0, 0, 2.0 / 3.0);
+  lv.b_coef(1, 1, -1.0);
+  lv.c_coef(0, 0, 1, -4.0 / 3.0);
+  lv.c_coef(1, 0, 1, 1.0);
+  lv.a_coef(0, 0.0);
+
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::string binary = (dir / "ode_lab_utest_model.q1b").string();
+  const std::string text = (dir / "ode_lab_utest_model.q1t").string();
+  qode::write_binary(binary, lv.terms());
+  qode::write_text(text, lv.terms());
+
+  auto from_binary = qode::qode1_file<double>::open(binary);
+  auto from_text = qode::qode1_file<double>::open(text);
+#if defined(__unix__) || defined(__APPLE__)
+  if (!from_binary->mapped())
+    ea << "binary model file was not memory-mapped";
+#endif
+
+  Lotka_Voltera core;
+  qode::qode1_mapped<double> run_binary(from_binary), run_text(from_text);
+  core.x = {1.0, 1.0};
+  run_binary.x = {1.0, 1.0};
+  run_text.x = {1.0, 1.0};
+  for (int i = 0; i < 100; ++i)
+  {
+    core.step(0.05);
+    run_binary.step(0.05);
+    run_text.step(0.05);
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    ea << utest::compare_numeric("wrong state x[" + std::to_string(i) + "] from binary model", core.x[i], run_binary.x[i]);
+    ea << utest::compare_numeric("wrong state x[" + std::to_string(i) + "] from text model", core.x[i], run_text.x[i]);
+  }
+
+  auto rejects = [&](const std::string &content, const std::string &what)
+  {
+    std::ofstream(text) << content;
+    try
+    {
+      qode::qode1_file<double>::open(text);
+      ea << "model file with " + what + " was accepted";
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+  };
+  rejects("qode1 2\nB 0 2 1.0\n", "an index out of range");
+  rejects("qode1 2\nD 0 1.0\n", "an unknown term");
+  rejects("2\nA 0 1.0\n", "a missing header");
+
+  try
+  {
+    qode::qode1_file<float>::open(binary);
+    ea << "binary model file with double values was accepted as float";
+  }
+  catch (const std::runtime_error &)
+  {
+  }
+
+  // term counts chosen so that the byte counts of the size check wrap to 0
+  {
+    char header[48] = {'Q', 'O', 'D', 'E', '1', 'B', 'I', 'N'};
+    const uint32_t version = 1, value_size = sizeof(double);
+    const uint64_t counts[4] = {2, uint64_t(1) << 62, 0, 0};
+    std::memcpy(header + 8, &version, 4);
+    std::memcpy(header + 12, &value_size, 4);
+    std::memcpy(header + 16, counts, sizeof(counts));
+    std::ofstream(binary, std::ios::binary).write(header, sizeof(header));
+    try
+    {
+      qode::qode1_file<double>::open(binary);
+      ea << "binary model file with overflowing term counts was accepted";
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+  }
+
+  try
+  {
+    lv.a_coef(2, 1.0);
+    ea << "qode1_coefficients accepted an index out of range";
+  }
+  catch (const std::out_of_range &)
+  {
+  }
+
+  std::filesystem::remove(binary);
+  std::filesystem::remove(text);
+}
+
+void test_trajectory(utest::error_accumulator &ea)
+{
+  const double mu = 0.03;
+
+  // adaptive source against the hand-written loop
+  Lotka_Voltera loop, lazy;
+  loop.x = {1.0, 1.0};
+  lazy.x = {1.0, 1.0};
+  double h_loop = loop.suggest_first_stepsize(1.0, mu);
+  double h_lazy = lazy.suggest_first_stepsize(1.0, mu);
+  double t = 0.0;
+  size_t steps = 0;
+  while (t < 5.0)
+  {
+    loop.step_adaptive(h_loop, mu);
+    t += h_loop;
+    steps++;
+  }
+
+  size_t points = 0;
+  bool views = true;
+  for (const auto &p : qode::adaptive_trajectory(lazy, 0.0, 5.0, h_lazy, mu))
+  {
+    points++;
+    views = views && p.x.data() == lazy.x.data();
+  }
+  ea << utest::compare_numeric("wrong number of trajectory points", double(steps + 1), double(points));
+  ea << utest::compare_numeric("wrong trajectory end state", loop.x[0], lazy.x[0]);
+  if (!views)
+    ea << "trajectory points do not view the integrator state";
+
+  // fixed steps with decimation, output-time sampling and early termination
+  auto fixed = [](Lotka_Voltera &core)
+  {
+    core.x = {1.0, 1.0};
+    return qode::fixed_trajectory(core, 0.0, 2.0, 0.1);
+  };
+
+  Lotka_Voltera core;
+  std::vector<double> every, at;
+  for (const auto &p : fixed(core))
+    every.push_back(p.x[0]);
+  ea << utest::compare_numeric("wrong number of fixed steps", 21.0, double(every.size()));
+
+  size_t kept = 0;
+  for (const auto &p : qode::decimate(fixed(core), 5))
+    ea << utest::compare_numeric("wrong decimated point", every[5 * kept++], p.x[0]);
+  ea << utest::compare_numeric("wrong number of decimated points", 5.0, double(kept));
+  try
+  {
+    qode::decimate(fixed(core), 0);
+    ea << "decimate with every == 0 was accepted";
+  }
+  catch (const std::invalid_argument &)
+  {
+  }
+
+  for (const auto &p : qode::sample(fixed(core), {0.5, 0.55, 1.95}))
+    at.push_back(p.x[0]);
+  if (at.size() != 3)
+    ea << "sample did not yield every output time";
+  else
+  {
+    ea << utest::compare_numeric("wrong sample at a step", every[5], at[0], 1e-14);
+    ea << utest::compare_numeric("wrong interpolated sample", (every[5] + every[6]) / 2, at[1], 1e-14);
+    ea << utest::compare_numeric("wrong last interpolated sample", (every[19] + every[20]) / 2, at[2], 1e-14);
+  }
+
+  size_t before_stop = 0;
+  double t_stop = 0.0;
+  // a function pointer, since a lambda type in the coroutine frame of a
+  // header-defined test trips -Wsubobject-linkage
+  for (const auto &p : qode::until(fixed(core), +[](const qode::trajectory_point<double> &p)
+                                   { return p.t >= 1.0 - 1e-12; }))
+  {
+    before_stop++;
+    t_stop = p.t;
+  }
+  ea << utest::compare_numeric("wrong early termination", 11.0, double(before_stop));
+  ea << utest::compare_numeric("integration continued after until", every[10], core.x[0], 1e-15);
+  ea << utest::compare_numeric("wrong time of the last point", 1.0, t_stop, 1e-12);
+
+  // consumer on its own thread sees the same points
+  std::vector<double> async;
+  qode::consume_async(fixed(core), 4, [&](const qode::trajectory_point<double> &p)
+                      { async.push_back(p.x[0]); });
+  if (async != every)
+    ea << "consume_async did not deliver the trajectory in order";
+
+  try
+  {
+    qode::consume_async(fixed(core), 2, [&](const qode::trajectory_point<double> &p)
+                        {
+                          if (p.t > 0.5)
+                            throw std::runtime_error("consumer"); });
+    ea << "consume_async did not rethrow the consumer exception";
+  }
+  catch (const std::runtime_error &)
+  {
+  }
+}
+
+void test_steady_state(utest::error_accumulator &ea)
+{
+  Lotka_Voltera lv;
+  lv.x = {1.0, 1.0};
+  double f[2], jac[4];
+  lv.evaluate(f, jac);
+  const double f_ref[2] = {-2.0 / 3.0, 0.0}, jac_ref[4] = {-2.0 / 3.0, -4.0 / 3.0, 1.0, 0.0};
+  for (size_t i = 0; i < 2; ++i)
+    ea << utest::compare_numeric("wrong evaluate f[" + std::to_string(i) + "]", f_ref[i], f[i], 1e-15);
+  for (size_t i = 0; i < 4; ++i)
+    ea << utest::compare_numeric("wrong evaluate jac[" + std::to_string(i) + "]", jac_ref[i], jac[i], 1e-15);
+
+  lv.set_imex(true);
+  double f_imex[2], jac_imex[4];
+  lv.evaluate(f_imex, jac_imex);
+  lv.evaluate(f_imex, jac_imex);
+  for (size_t i = 0; i < 4; ++i)
+    ea << utest::compare_numeric("wrong IMEX evaluate jac[" + std::to_string(i) + "]", jac[i], jac_imex[i], 1e-15);
+  ea << utest::compare_numeric("wrong IMEX evaluate f[0]", f[0], f_imex[0], 1e-15);
+
+  // the Lotka-Volterra equilibrium (1, 1/2) is a centre, integration never
+  // reaches it; Newton does
+  qode::steady_state_solver<double> solver;
+  solver.tol = 1e-13;
+  Lotka_Voltera centre;
+  centre.x = {1.3, 0.3};
+  const auto res = solver.solve(centre);
+  if (!res.converged || res.iterations > 30)
+    ea << "steady state of Lotka-Volterra not found";
+  ea << utest::compare_numeric("wrong equilibrium x[0]", 1.0, centre.x[0], 1e-12);
+  ea << utest::compare_numeric("wrong equilibrium x[1]", 0.5, centre.x[1], 1e-12);
+
+  // a dissipative chain: the equilibrium is the long-time limit
+  const size_t n = 6;
+  Stiff_chain chain(n), integrated(n);
+  chain.stiffness = integrated.stiffness = 20.0;
+  chain.x.assign(n, 1.0);
+  integrated.x.assign(n, 1.0);
+  for (int i = 0; i < 2000; ++i)
+    integrated.step(0.01);
+
+  const auto res_chain = solver.solve(chain);
+  if (!res_chain.converged)
+    ea << "steady state of the dissipative chain not found";
+  for (size_t i = 0; i < n; ++i)
+    ea << utest::compare_numeric("wrong chain equilibrium x[" + std::to_string(i) + "]", integrated.x[i], chain.x[i], 1e-10);
+}
+
+double composition_error(const qode::composition<double> &c, const double h, const double reference)
+{
+  Lotka_Voltera core;
+  core.x = {1.0, 1.0};
+  const int steps = int(std::lround(4.0 / h));
+  for (int i = 0; i < steps; ++i)
+    c.step(core, h);
+  return std::abs(core.x[0] - reference);
+}
+
+void test_composition(utest::error_accumulator &ea)
+{
+  const qode::composition<double> reference_method(8, qode::composition_scheme::suzuki_fractal);
+  Lotka_Voltera ref;
+  ref.x = {1.0, 1.0};
+  for (int i = 0; i < 400; ++i)
+    reference_method.step(ref, 0.01);
+
+  auto check_order = [&](const int order, const qode::composition_scheme scheme, const double h)
+  {
+    const qode::composition<double> c(order, scheme);
+    const double observed = std::log2(composition_error(c, h, ref.x[0]) / composition_error(c, h / 2, ref.x[0]));
+    ea << utest::compare_numeric("wrong observed order of composition " + std::to_string(order) + " (scheme " + std::to_string(int(scheme)) + ")",
+                                 double(order), observed, 0.3);
+  };
+
+  check_order(2, qode::composition_scheme::triple_jump, 0.1);
+  check_order(4, qode::composition_scheme::triple_jump, 0.2);
+  check_order(4, qode::composition_scheme::suzuki_fractal, 0.2);
+  check_order(6, qode::composition_scheme::triple_jump, 0.4);
+  check_order(6, qode::composition_scheme::yoshida_optimal, 0.4);
+
+  const qode::composition<double> c4(4, qode::composition_scheme::suzuki_fractal);
+
+  double sum = 0.0, gamma_max = 0.0;
+  for (const double g : c4.coefficients())
+  {
+    sum += g;
+    gamma_max = std::max(gamma_max, std::abs(g));
+  }
+  ea << utest::compare_numeric("composition coefficients do not sum to one", 1.0, sum, 1e-15);
+
+  // step_adaptive == the core's proposal for mu / max |g_i|, then a fixed
+  // composed step with it
+  Lotka_Voltera core, expected;
+  core.x = expected.x = {1.0, 1.0};
+  const double mu = 0.3;
+  double h = c4.suggest_first_stepsize(core, 1.0, mu);
+  double h_expected = expected.suggest_first_stepsize(1.0, mu / gamma_max);
+  ea << utest::compare_numeric("wrong composition::suggest_first_stepsize", h_expected, h);
+  for (int i = 0; i < 2; ++i)
+  {
+    c4.step_adaptive(core, h, mu);
+    expected.adapt_stepsize(h_expected, mu / gamma_max);
+    c4.step(expected, h_expected);
+    ea << utest::compare_numeric("wrong stepsize of composition::step_adaptive", h_expected, h);
+    for (size_t k = 0; k < 2; ++k)
+      ea << utest::compare_numeric("wrong state x[" + std::to_string(k) + "] after composition::step_adaptive", expected.x[k], core.x[k]);
+  }
+}
+
+void test_richardson_controller(utest::error_accumulator &ea)
+{
+  const double t_end = 4.0;
+
+  const qode::composition<double> reference_method(8, qode::composition_scheme::suzuki_fractal);
+  Lotka_Voltera ref;
+  ref.x = {1.0, 1.0};
+  for (int i = 0; i < 400; ++i)
+    reference_method.step(ref, 0.01);
+
+  for (const bool extrapolate : {false, true})
+    for (const double tol : {1e-6, 1e-9})
+    {
+      qode::richardson_controller<double> ctrl(tol, tol);
+      ctrl.extrapolate = extrapolate;
+
+      Lotka_Voltera core;
+      core.x = {1.0, 1.0};
+      double t = 0.0, h = 1.0;
+      while (t < t_end)
+        t += ctrl.step(core, h, t_end - t);
+
+      const std::string msg = std::string("richardson_controller (extrapolate = ") + (extrapolate ? "true" : "false") + ", tol = " + std::to_string(tol) + ")";
+      ea << utest::compare_numeric(msg + " does not stop at t_end", t_end, t, 1e-14);
+      // tolerance per step: the global error may grow with the number of steps
+      const double global_tol = extrapolate ? 10 * tol : 2 * double(ctrl.accepted) * tol;
+      ea << utest::compare_numeric(msg + " misses the tolerance", ref.x[0], core.x[0], global_tol);
+      if (ctrl.rejected == 0)
+        ea << msg + " did not reject the oversized first step";
+    }
+}
+
+template <size_t n>
+class Oscillator_verlet : public qode::verlet<double, n>
+{
+public:
+  Oscillator_verlet() = default;
+  explicit Oscillator_verlet(const size_t size) : qode::verlet<double, n>(size) {}
+
+  void acceleration(const double x[], double a[]) override
+  {
+    a[0] = -x[0];
+  }
+};
+
+double verlet_error(const qode::composition<double> *scheme, const double h)
+{
+  Oscillator_verlet<1> osc;
+  osc.x[0] = 1.0;
+  const int steps = int(std::lround(2.0 / h));
+  for (int i = 0; i < steps; ++i)
+    scheme ? osc.step(h, *scheme) : osc.step(h);
+  return std::hypot(osc.x[0] - std::cos(2.0), osc.u[0] + std::sin(2.0));
+}
+
+void test_verlet(utest::error_accumulator &ea)
+{
+  const double order2 = std::log2(verlet_error(nullptr, 0.02) / verlet_error(nullptr, 0.01));
+  ea << utest::compare_numeric("wrong observed order of velocity Verlet", 2.0, order2, 0.1);
+
+  const qode::composition<double> c4(4, qode::composition_scheme::triple_jump);
+  const double order4 = std::log2(verlet_error(&c4, 0.1) / verlet_error(&c4, 0.05));
+  ea << utest::compare_numeric("wrong observed order of composed Verlet", 4.0, order4, 0.2);
+
+  // symplectic: the energy error stays bounded over long times
+  Oscillator_verlet<0> osc(1);
+  osc.x[0] = 1.0;
+  double max_drift = 0.0;
+  for (int i = 0; i < 100000; ++i)
+  {
+    osc.step(0.1);
+    max_drift = std::max(max_drift, std::abs(osc.x[0] * osc.x[0] + osc.u[0] * osc.u[0] - 1.0));
+  }
+  if (max_drift > 0.01)
+    ea << "velocity Verlet energy drift " + std::to_string(max_drift) + " exceeds the bounded oscillation";
+
+  // x_changed() discards the cached acceleration
+  Oscillator_verlet<1> fixed;
+  fixed.x[0] = 1.0;
+  fixed.step(0.1);
+  fixed.x[0] = 1.0;
+  fixed.u[0] = 0.0;
+  fixed.x_changed();
+  fixed.step(0.1);
+  Oscillator_verlet<1> fresh;
+  fresh.x[0] = 1.0;
+  fresh.step(0.1);
+  ea << utest::compare_numeric("x_changed does not refresh the acceleration", fresh.u[0], fixed.u[0], 1e-16);
+}
+
+class Relaxation_ricatti : public qode::ricatti_core<double>
+{
+public:
+  Relaxation_ricatti() : qode::ricatti_core<double>(2) {};
+
+  void set_coef() override
+  {
+    a_coef(0) = 1.0;
+    b_coef(0, 0) = -50.0;
+    b_coef(0, 1) = 10.0;
+    b_coef(1, 1) = -0.5;
+  }
+};
+
+class Lotka_Voltera_ricatti : public qode::ricatti_core<double>
+{
+public:
+  Lotka_Voltera_ricatti() : qode::ricatti_core<double>(2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+void test_ricatti(utest::error_accumulator &ea)
+{
+  // linear systems are integrated exactly, whatever the stepsize
+  Relaxation_ricatti lin;
+  lin.x = {2.0, 1.0};
+  lin.step(1.0);
+
+  const double y = std::exp(-0.5);
+  const double c = 10.0 / 49.5;
+  const double x = 1.0 / 50.0 + c * y + (2.0 - 1.0 / 50.0 - c) * std::exp(-50.0);
+  ea << utest::compare_numeric("ricatti_core is not exact for a linear system (x)", x, lin.x[0], 1e-13);
+  ea << utest::compare_numeric("ricatti_core is not exact for a linear system (y)", y, lin.x[1], 1e-13);
+
+  // the exponential step also runs through a qode1_core reference
+  Relaxation_ricatti direct, through_base;
+  direct.x = through_base.x = {2.0, 1.0};
+  qode::qode1_core<double> &base = through_base;
+  double h_direct = 0.1, h_base = 0.1;
+  direct.step_adaptive(h_direct, 0.5);
+  base.step_adaptive(h_base, 0.5);
+  direct.step(0.3);
+  base.step(0.3);
+  ea << utest::compare_numeric("qode1_core& does not run the ricatti_core step", direct.x[0], through_base.x[0]);
+
+  // finish_step reads mat as J(x), which IMEX mode would not assemble
+  try
+  {
+    base.set_imex(true);
+    ea << "ricatti_core accepted IMEX mode";
+  }
+  catch (const std::invalid_argument &)
+  {
+  }
+
+  // order 2 on the quadratic system
+  auto error = [](const double h)
+  {
+    Lotka_Voltera_ricatti lv;
+    lv.x = {1.0, 1.0};
+    const int steps = int(std::lround(4.0 / h));
+    for (int i = 0; i < steps; ++i)
+      lv.step(h);
+
+    Lotka_Voltera ref;
+    ref.x = {1.0, 1.0};
+    const qode::composition<double> c6(6, qode::composition_scheme::yoshida_optimal);
+    for (int i = 0; i < 400; ++i)
+      c6.step(ref, 0.01);
+    return std::hypot(lv.x[0] - ref.x[0], lv.x[1] - ref.x[1]);
+  };
+  ea << utest::compare_numeric("wrong observed order of ricatti_core", 2.0, std::log2(error(0.02) / error(0.01)), 0.1);
+}
+
+class Diagonal_lyapunov : public qode::qode1_lyapunov<double>
+{
+public:
+  Diagonal_lyapunov() : qode::qode1_lyapunov<double>(2, 2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = -1.0;
+    b_coef(1, 1) = -3.0;
+  }
+};
+
+class Lorenz_lyapunov : public qode::qode1_lyapunov<double>
+{
+public:
+  Lorenz_lyapunov() : qode::qode1_lyapunov<double>(3, 3) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = -10.0;
+    b_coef(0, 1) = 10.0;
+
+    b_coef(1, 0) = 28.0;
+    b_coef(1, 1) = -1.0;
+    c_coef(1, 0, 2) = -1.0;
+
+    b_coef(2, 2) = -8.0 / 3.0;
+    c_coef(2, 0, 1) = 1.0;
+  }
+};
+
+class Overfull_lyapunov : public qode::qode1_lyapunov<double>
+{
+public:
+  Overfull_lyapunov() : qode::qode1_lyapunov<double>(2, 3) {};
+
+  void set_coef() override
+  {
+  }
+};
+
+void test_lyapunov(utest::error_accumulator &ea)
+{
+  Diagonal_lyapunov diag;
+  diag.x = {1.0, 1.0};
+  diag.reset_tangents();
+  const double h = 0.01;
+  for (int i = 0; i < 1000; ++i)
+    diag.step(h);
+  diag.synchronize();
+
+  // exact exponents of the qode1 step: log|(1 + h b/2) / (1 - h b/2)| / h
+  const std::vector<double> lambda = diag.exponents();
+  ea << utest::compare_numeric("wrong Lyapunov exponent of diagonal system (0)", std::log((1 - h / 2) / (1 + h / 2)) / h, lambda[0], 1e-12);
+  ea << utest::compare_numeric("wrong Lyapunov exponent of diagonal system (1)", std::log((1 - 3 * h / 2) / (1 + 3 * h / 2)) / h, lambda[1], 1e-12);
+
+  // stepped through a qode1_core&, with a step count that is not a multiple
+  // of orthonormalize_every
+  Diagonal_lyapunov sparse;
+  qode::qode1_core<double> &base = sparse;
+  sparse.x = {1.0, 1.0};
+  sparse.reset_tangents();
+  sparse.orthonormalize_every = 7;
+  for (int i = 0; i < 1000; ++i)
+    base.step(h);
+  sparse.synchronize();
+  const std::vector<double> lambda_sparse = sparse.exponents();
+  ea << utest::compare_numeric("wrong Lyapunov exponent with sparse orthonormalisation (0)", lambda[0], lambda_sparse[0], 1e-12);
+  ea << utest::compare_numeric("wrong Lyapunov exponent with sparse orthonormalisation (1)", lambda[1], lambda_sparse[1], 1e-12);
+
+  try
+  {
+    base.set_imex(true);
+    ea << "qode1_lyapunov accepted IMEX mode";
+  }
+  catch (const std::invalid_argument &)
+  {
+  }
+
+  Lorenz_lyapunov lorenz;
+  lorenz.x = {1.0, 1.0, 1.0};
+  for (int i = 0; i < 1000; ++i)
+    lorenz.step(h);
+  lorenz.reset_tangents();
+  lorenz.orthonormalize_every = 5;
+  for (int i = 0; i < 50000; ++i)
+    lorenz.step(h);
+  lorenz.synchronize();
+
+  const std::vector<double> l = lorenz.exponents();
+
+  // under richardson_controller the tangents follow the accepted steps
+  // only, i.e. equal a replay of the accepted pairs of half steps
+  Lorenz_lyapunov controlled, replay;
+  controlled.x = replay.x = {1.0, 1.0, 1.0};
+  controlled.orthonormalize_every = replay.orthonormalize_every = 3;
+  qode::richardson_controller<double> ctrl(1e-7, 1e-7);
+  double h_ctrl = 0.2, t = 0.0;
+  while (t < 5.0)
+  {
+    const double taken = ctrl.step(controlled, h_ctrl, 5.0 - t);
+    t += taken;
+    replay.step(taken / 2);
+    replay.step(taken / 2);
+  }
+  controlled.synchronize();
+  replay.synchronize();
+  if (ctrl.rejected == 0)
+    ea << "Lyapunov controller test has no rejected step";
+  const std::vector<double> l_controlled = controlled.exponents(), l_replay = replay.exponents();
+  for (size_t j = 0; j < 3; ++j)
+    ea << utest::compare_numeric("controlled Lyapunov exponent differs from a replay (" + std::to_string(j) + ")", l_replay[j], l_controlled[j], 1e-9);
+
+  try
+  {
+    Overfull_lyapunov overfull;
+    ea << "qode1_lyapunov accepted more tangent vectors than dimensions";
+  }
+  catch (const std::invalid_argument &)
+  {
+  }
+  ea << utest::compare_numeric("wrong leading Lorenz exponent", 0.906, l[0], 0.1);
+  ea << utest::compare_numeric("wrong middle Lorenz exponent", 0.0, l[1], 0.05);
+  ea << utest::compare_numeric("Lorenz exponents do not sum to the trace", -(10.0 + 1.0 + 8.0 / 3.0), l[0] + l[1] + l[2], 0.05);
+}
+
+void test_qode1_sensitivity(utest::error_accumulator &ea)
+{
+  // Lotka-Volterra with a parameterized inflow
+  auto model = std::make_shared<qode::qode1_model<double>>(2, 5);
+  model->b_param(0, 0, 0);
+  model->b_param(1, 1, 1);
+  model->c_param(0, 0, 1, 2);
+  model->c_param(1, 0, 1, 3);
+  model->a_param(1, 4, 0.5);
+
+  const std::vector<double> theta = {2.0 / 3.0, -1.0, -4.0 / 3.0, 1.0, 0.1};
+  const double h = 0.05;
+  const int steps = 80;
+
+  qode::qode1_sensitivity<double> sens(model);
+  sens.theta = theta;
+  sens.x = {1.0, 1.0};
+  for (int i = 0; i < steps; ++i)
+    sens.step(h);
+
+  // alternating with another instance on the same thread, and restarted
+  // from a new x (the assembly kept from the last step must not be reused)
+  qode::qode1_sensitivity<double> restarted(model), other(model);
+  restarted.theta = theta;
+  other.theta = {1.0, -2.0, -1.0, 2.0, 0.3};
+  restarted.x = {0.5, 2.0};
+  other.x = {2.0, 0.5};
+  for (int i = 0; i < steps / 2; ++i)
+    restarted.step(h);
+  restarted.x = {1.0, 1.0};
+  restarted.reset_sensitivities();
+  for (int i = 0; i < steps; ++i)
+  {
+    restarted.step(h);
+    other.step(h);
+  }
+  for (size_t i = 0; i < sens.S.size(); ++i)
+    ea << utest::compare_numeric("sensitivities depend on other instances or a stale assembly", sens.S[i], restarted.S[i]);
+
+  // through a qode1_instance&
+  qode::qode1_sensitivity<double> via_base(model);
+  qode::qode1_instance<double> &base = via_base;
+  via_base.theta = theta;
+  via_base.x = {1.0, 1.0};
+  for (int i = 0; i < steps; ++i)
+    base.step(h);
+  for (size_t i = 0; i < sens.S.size(); ++i)
+    ea << utest::compare_numeric("qode1_instance& does not run the sensitivity step", sens.S[i], via_base.S[i]);
+
+  // under richardson_controller: S follows the accepted steps only, i.e.
+  // equals a replay of the accepted pairs of half steps
+  qode::qode1_sensitivity<double> controlled(model), replay(model);
+  controlled.theta = replay.theta = theta;
+  controlled.x = replay.x = {1.0, 1.0};
+  qode::richardson_controller<double> ctrl(1e-9, 1e-9);
+  double h_ctrl = 0.5, t = 0.0;
+  while (t < 4.0)
+  {
+    const double taken = ctrl.step(controlled, h_ctrl, 4.0 - t);
+    t += taken;
+    replay.step(taken / 2);
+    replay.step(taken / 2);
+  }
+  if (ctrl.rejected == 0)
+    ea << "sensitivity controller test has no rejected step";
+  for (size_t i = 0; i < sens.S.size(); ++i)
+    ea << utest::compare_numeric("controlled sensitivities differ from a replay", replay.S[i], controlled.S[i], 1e-12);
+
+  // central differences of the same discrete trajectory
+  for (size_t p = 0; p < theta.size(); ++p)
+  {
+    const double d = 1e-6;
+    double xp[2], xm[2];
+    for (const int sign : {1, -1})
+    {
+      qode::qode1_instance<double> run(model);
+      run.theta = theta;
+      run.theta[p] += sign * d;
+      run.x = {1.0, 1.0};
+      for (int i = 0; i < steps; ++i)
+        run.step(h);
+      (sign > 0 ? xp : xm)[0] = run.x[0];
+      (sign > 0 ? xp : xm)[1] = run.x[1];
+    }
+    for (size_t i = 0; i < 2; ++i)
+      ea << utest::compare_numeric("wrong sensitivity dx" + std::to_string(i) + "/dtheta" + std::to_string(p),
+                                   (xp[i] - xm[i]) / (2 * d), sens.sensitivity(i, p), 1e-7);
+  }
+}
+
+void test_qode1_adjoint(utest::error_accumulator &ea)
+{
+  auto model = std::make_shared<qode::qode1_model<double>>(2, 5);
+  model->b_param(0, 0, 0);
+  model->b_param(1, 1, 1);
+  model->c_param(0, 0, 1, 2);
+  model->c_param(1, 0, 1, 3);
+  model->a_param(1, 4, 0.5);
+
+  const std::vector<double> theta = {2.0 / 3.0, -1.0, -4.0 / 3.0, 1.0, 0.1};
+  const double h = 0.05;
+  const size_t steps = 77;
+
+  // L = x_N[0] + sum_n x_n[1]^2 / 2
+  qode::qode1_adjoint<double> adj(model);
+  adj.theta = theta;
+  adj.x = {1.0, 1.0};
+  adj.gradient(steps, h, [](size_t i, const double *x, double *lambda)
+               {
+                 if (i == steps)
+                   lambda[0] += 1.0;
+                 lambda[1] += x[1]; });
+
+  auto loss = [&](const std::vector<double> &th, const std::vector<double> &x0)
+  {
+    qode::qode1_instance<double> run(model);
+    run.theta = th;
+    run.x = x0;
+    double l = run.x[1] * run.x[1] / 2;
+    for (size_t i = 0; i < steps; ++i)
+    {
+      run.step(h);
+      l += run.x[1] * run.x[1] / 2;
+    }
+    return l + run.x[0];
+  };
+
+  const double d = 1e-6;
+  for (size_t p = 0; p < theta.size(); ++p)
+  {
+    std::vector<double> tp = theta, tm = theta;
+    tp[p] += d;
+    tm[p] -= d;
+    ea << utest::compare_numeric("wrong adjoint dL/dtheta" + std::to_string(p), (loss(tp, {1.0, 1.0}) - loss(tm, {1.0, 1.0})) / (2 * d), adj.grad[p], 1e-6);
+  }
+  for (size_t i = 0; i < 2; ++i)
+  {
+    std::vector<double> xp = {1.0, 1.0}, xm = {1.0, 1.0};
+    xp[i] += d;
+    xm[i] -= d;
+    ea << utest::compare_numeric("wrong adjoint dL/dx0_" + std::to_string(i), (loss(theta, xp) - loss(theta, xm)) / (2 * d), adj.lambda[i], 1e-6);
+  }
+  if (adj.checkpoint.peak_states > 8)
+    ea << "qode1_adjoint keeps more than log2(N) + 1 states";
+}
+
+void test_symmetric_kernel(utest::error_accumulator &ea)
+{
+  std::vector<size_t> sizes;
+  for (size_t n = 1; n <= 20; ++n)
+    sizes.push_back(n);
+  sizes.push_back(300);
+
+  for (const size_t n : sizes)
+  {
+    const double h = 0.1;
+    std::vector<double> mat(n * n), vec(n), x(n);
+    for (size_t i = 0; i < n * n; ++i)
+      mat[i] = std::sin(1.7 * double(i) + double(n));
+    for (size_t i = 0; i < n; ++i)
+    {
+      vec[i] = std::cos(0.9 * double(i));
+      x[i] = 1.0 + 0.1 * double(i);
+    }
+    std::vector<double> mat_ref = mat, x_ref = x;
+
+    qode::symmetric_update(n, h, mat_ref.data(), vec.data(), x_ref.data());
+    qode::select_symmetric_kernel<double>(n)(n, h, mat.data(), vec.data(), x.data());
+
+    for (size_t i = 0; i < n; ++i)
+      ea << utest::compare_numeric("wrong symmetric kernel for n = " + std::to_string(n) + ", x[" + std::to_string(i) + "]", x_ref[i], x[i], 1e-14);
+  }
+
+  // thresholds from a kernel configuration
+  std::istringstream tuned("double 4 40 16\n");
+  math::load_kernel_config(tuned);
+  if (qode::select_symmetric_kernel<double>(4) == &qode::symmetric_update<double> ||
+      qode::select_symmetric_kernel<double>(5) != &qode::symmetric_update<double> ||
+      qode::select_symmetric_kernel<double>(39) != &qode::symmetric_update<double> ||
+      qode::select_symmetric_kernel<double>(40) != &qode::symmetric_solve_blocked<double>)
+    ea << "select_symmetric_kernel does not follow the configured thresholds";
+  std::istringstream defaults("double 16 17 32\n");
+  math::load_kernel_config(defaults);
+}
+
+void test_qode1_stats(utest::error_accumulator &ea)
+{
+  Lotka_Voltera core;
+  core.x = {1.0, 1.0};
+  double h = core.suggest_first_stepsize(1.0, 0.03);
+  for (int i = 0; i < 10; ++i)
+    core.step_adaptive(h, 0.03);
+  core.step(h);
+
+  if constexpr (math::stats_level >= 1)
+  {
+    ea << utest::compare_numeric("wrong qode1_core steps", 11.0, double(core.stats.get(math::counter::steps)));
+    ea << utest::compare_numeric("wrong qode1_core assemblies", 12.0, double(core.stats.get(math::counter::assemblies)));
+    ea << utest::compare_numeric("wrong qode1_core factorizations", 11.0, double(core.stats.get(math::counter::factorizations)));
+  }
+  else
+  {
+    ea << utest::compare_numeric("qode1_core counts with statistics off", 0.0, double(core.stats.get(math::counter::steps)));
+  }
+}
+
+class Lotka_Voltera_lyapunov : public qode::qode1_lyapunov<double>
+{
+public:
+  Lotka_Voltera_lyapunov() : qode::qode1_lyapunov<double>(2, 2) {};
+
+  void set_coef() override
+  {
+    b_coef(0, 0) = 2.0 / 3.0;
+    b_coef(1, 1) = -1.0;
+
+    c_coef(0, 0, 1) = -4.0 / 3.0;
+    c_coef(1, 0, 1) = 1.0;
+  }
+};
+
+// every integrator compiles under richardson_controller (including its
+// use of `stats`) and reaches the same state of the Lotka-Volterra system
+void test_controlled_integrators(utest::error_accumulator &ea)
+{
+  const double t_end = 2.0;
+  auto drive = [&](auto &core)
+  {
+    core.x = {1.0, 1.0};
+    qode::richardson_controller<double> ctrl(1e-9, 1e-9);
+    double h = 0.1, t = 0.0;
+    while (t < t_end)
+      t += ctrl.step(core, h, t_end - t);
+    return std::vector<double>(core.x.begin(), core.x.end());
+  };
+
+  Lotka_Voltera core;
+  const std::vector<double> expected = drive(core);
+
+  auto model = std::make_shared<qode::qode1_model<double>>(2, 0);
+  model->b_coef(0, 0, 2.0 / 3.0);
+  model->b_coef(1, 1, -1.0);
+  model->c_coef(0, 0, 1, -4.0 / 3.0);
+  model->c_coef(1, 0, 1, 1.0);
+
+  Lotka_Voltera_mixed mixed;
+  qode::qode1_static<double, lotka_volterra_model> fixed;
+  qode::qode1_instance<double> instance(model);
+  qode::qode1_sensitivity<double> sensitivity(model);
+  qode::qode1_adjoint<double> adjoint(model);
+  Lotka_Voltera_ricatti ricatti;
+  Lotka_Voltera_lyapunov lyapunov;
+
+  auto check = [&](const std::string &name, const std::vector<double> &x, const double tol)
+  {
+    for (size_t i = 0; i < 2; ++i)
+      ea << utest::compare_numeric("wrong state x[" + std::to_string(i) + "] of controlled " + name, expected[i], x[i], tol);
+  };
+  check("qode1_core<double, float>", drive(mixed), 1e-7);
+  check("qode1_static", drive(fixed), 1e-12);
+  check("qode1_instance", drive(instance), 1e-12);
+  check("qode1_sensitivity", drive(sensitivity), 1e-12);
+  check("qode1_adjoint", drive(adjoint), 1e-12);
+  check("ricatti_core", drive(ricatti), 1e-6);
+  check("qode1_lyapunov", drive(lyapunov), 1e-12);
+}
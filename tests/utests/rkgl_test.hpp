@@ -0,0 +1,264 @@
+#pragma once
+#include <utest_frame.hpp>
+#include <precision_test.hpp>
+#include <rkgl.hpp>
+#include <gauss_legendre.hpp>
+#include <double_double.hpp>
+#include <checkpoint.hpp>
+#include <vector>
+#include <cmath>
+#include <string>
+
+template <class U, int order>
+void subtest_gauss_legendre_vs_table(utest::error_accumulator &ea)
+{
+  constexpr auto generated = rkgl::gauss_legendre<U, order>();
+  const auto &table = rkgl::A<U, order>;
+
+  for (int i = 0; i <= order; ++i)
+    for (int j = 0; j < order; ++j)
+      ea << compare_precision("gauss_legendre<" + std::to_string(order) + "> differs from rkgl::A at (" + std::to_string(i) + ", " + std::to_string(j) + ")",
+                              table[i][j], generated.a[i][j], eps<U> * 4);
+}
+
+void test_gauss_legendre(utest::error_accumulator &ea)
+{
+  subtest_gauss_legendre_vs_table<double, 1>(ea);
+  subtest_gauss_legendre_vs_table<double, 2>(ea);
+  subtest_gauss_legendre_vs_table<double, 3>(ea);
+  subtest_gauss_legendre_vs_table<math::double_double, 1>(ea);
+  subtest_gauss_legendre_vs_table<math::double_double, 2>(ea);
+  subtest_gauss_legendre_vs_table<math::double_double, 3>(ea);
+
+  subtest_rkgl_table_precision<double, 4>(ea);
+  subtest_rkgl_table_precision<double, 6>(ea);
+  subtest_rkgl_table_precision<double, 7>(ea);
+}
+
+template <int order>
+double rkgl_oscillator_error(const double h)
+{
+  rkgl::rkgl<double, order> core;
+  core.set(2);
+  rkgl::mini_jacobian<double> mj;
+  mj.set(2);
+
+  auto f = [](const double *x, double *y)
+  {
+    y[0] = x[1];
+    y[1] = -x[0];
+  };
+
+  double x[2] = {1.0, 0.0};
+  const int steps = int(std::lround(4.0 / h));
+  for (int i = 0; i < steps; ++i)
+  {
+    mj.evaluate(f, x, h);
+    core.step(f, mj, x, h, 1e-15);
+  }
+
+  return std::hypot(x[0] - std::cos(steps * h), x[1] + std::sin(steps * h));
+}
+
+template <int order>
+void subtest_rkgl_convergence_order(utest::error_accumulator &ea, const double h)
+{
+  const double ratio = rkgl_oscillator_error<order>(h) / rkgl_oscillator_error<order>(h / 2);
+  const double observed = std::log2(ratio);
+  ea << utest::compare_numeric("wrong observed order of rkgl<" + std::to_string(order) + ">", 2.0 * order, observed, 0.2);
+}
+
+void test_rkgl_step(utest::error_accumulator &ea)
+{
+  subtest_rkgl_convergence_order<1>(ea, 0.1);
+  subtest_rkgl_convergence_order<2>(ea, 0.2);
+  subtest_rkgl_convergence_order<3>(ea, 0.5);
+  subtest_rkgl_convergence_order<4>(ea, 1.0);
+}
+
+// x0' = x1, x1' = -w x0 - 0.1 x0^2; loss L = x0(T)
+struct rkgl_adjoint_problem
+{
+  double w;
+  static constexpr double h = 0.1;
+  static constexpr size_t steps = 37;
+
+  void f(const double *x, double *y) const
+  {
+    y[0] = x[1];
+    y[1] = -w * x[0] - 0.1 * x[0] * x[0];
+  }
+
+  double loss(const double x0) const
+  {
+    rkgl::rkgl<double, 3> core;
+    core.set(2);
+    rkgl::mini_jacobian<double> mj;
+    mj.set(2);
+    auto rhs = [this](const double *x, double *y)
+    { f(x, y); };
+
+    double x[2] = {x0, 0.0};
+    for (size_t i = 0; i < steps; ++i)
+    {
+      mj.evaluate(rhs, x, h);
+      core.step(rhs, mj, x, h, 1e-15);
+    }
+    return x[0];
+  }
+};
+
+void test_rkgl_adjoint(utest::error_accumulator &ea)
+{
+  const rkgl_adjoint_problem problem{1.3};
+  const double h = rkgl_adjoint_problem::h;
+
+  rkgl::rkgl<double, 3> core;
+  core.set(2);
+  rkgl::mini_jacobian<double> mj;
+  mj.set(2);
+  auto rhs = [&](const double *x, double *y)
+  { problem.f(x, y); };
+  auto vjp = [&](const double *y, const double *w, double *out)
+  {
+    out[0] = (-problem.w - 0.2 * y[0]) * w[1];
+    out[1] = w[0];
+  };
+  double grad_w = 0.0;
+  auto stage = [&](const double *y, const double *k_bar)
+  { grad_w -= y[0] * k_bar[1]; };
+
+  double lambda[2] = {1.0, 0.0};
+  auto forward = [&](std::vector<double> &x, size_t)
+  {
+    mj.evaluate(rhs, x.data(), h);
+    core.step(rhs, mj, x.data(), h, 1e-15);
+  };
+  auto backward = [&](const std::vector<double> &x_i, size_t)
+  {
+    std::vector<double> x = x_i;
+    mj.evaluate(rhs, x.data(), h);
+    core.step(rhs, mj, x.data(), h, 1e-15);
+    core.adjoint_step(vjp, stage, x_i.data(), h, lambda, 1e-15);
+  };
+  const math::checkpoint_stats stats = math::bisection_reverse(rkgl_adjoint_problem::steps, std::vector<double>{1.0, 0.0}, forward, backward);
+
+  const double d = 1e-6;
+  const double dl_dx0 = (problem.loss(1.0 + d) - problem.loss(1.0 - d)) / (2 * d);
+  const double dl_dw = (rkgl_adjoint_problem{problem.w + d}.loss(1.0) - rkgl_adjoint_problem{problem.w - d}.loss(1.0)) / (2 * d);
+
+  ea << utest::compare_numeric("wrong rkgl adjoint dL/dx0", dl_dx0, lambda[0], 1e-8);
+  ea << utest::compare_numeric("wrong rkgl adjoint dL/dw", dl_dw, grad_w, 1e-8);
+  if (stats.peak_states > 7)
+    ea << "bisection_reverse keeps more than log2(N) + 1 states";
+}
+
+void test_rkgl_predictor(utest::error_accumulator &ea)
+{
+  auto f = [](const double *x, double *y)
+  {
+    y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+    y[1] = x[0] * x[1] - x[1];
+  };
+
+  auto run = [&](const bool predictor, double *x)
+  {
+    rkgl::rkgl<double, 3> core;
+    core.set(2);
+    core.predictor = predictor;
+    rkgl::mini_jacobian<double> mj;
+    mj.set(2);
+
+    for (int i = 0; i < 100; ++i)
+    {
+      mj.evaluate(f, x, 0.1);
+      core.step(f, mj, x, 0.1, 1e-14);
+    }
+    return core.total_iterations;
+  };
+
+  double x_pred[2] = {1.0, 1.0}, x_plain[2] = {1.0, 1.0};
+  const size_t with_predictor = run(true, x_pred);
+  const size_t without_predictor = run(false, x_plain);
+
+  ea << utest::compare_numeric("rkgl predictor changes the solution (0)", x_plain[0], x_pred[0], 1e-12);
+  ea << utest::compare_numeric("rkgl predictor changes the solution (1)", x_plain[1], x_pred[1], 1e-12);
+  if (!(with_predictor < without_predictor))
+    ea << "rkgl predictor does not reduce the sweeps: " + std::to_string(with_predictor) + " vs " + std::to_string(without_predictor);
+}
+
+void test_mini_jacobian_fused(utest::error_accumulator &ea)
+{
+  constexpr size_t n = 5;
+  auto f = [](const double *x, double *y)
+  {
+    for (size_t i = 0; i < n; ++i)
+      y[i] = std::sin(x[(i + 1) % n]) - 0.3 * x[i] * x[(i + 2) % n];
+  };
+  auto identity = [](size_t m, const double *x, double *cx)
+  {
+    for (size_t i = 0; i < m; ++i)
+      cx[i] = x[i];
+  };
+
+  const double x[n] = {0.3, -1.2, 0.7, 2.1, -0.4};
+  rkgl::mini_jacobian<double> fused, general;
+  fused.set(n);
+  general.set(n);
+  const int k_fused = fused.evaluate(f, x, 0.05);
+  const int k_general = general.evaluate(f, x, 0.05, identity);
+
+  if (k_fused != k_general)
+    ea << "mini_jacobian fused and general evaluate differ in rank";
+  ea << utest::compare_numeric("wrong fused mini_jacobian spectral radius", general.spectral_radius_estimate(), fused.spectral_radius_estimate(), 1e-13);
+
+  for (size_t j = 0; j < n; ++j)
+  {
+    double e[n] = {}, y_fused[n], y_general[n];
+    e[j] = 1.0;
+    fused.aply(e, y_fused);
+    general.aply(e, y_general);
+    for (size_t i = 0; i < n; ++i)
+      ea << utest::compare_numeric("wrong fused mini_jacobian::aply(" + std::to_string(i) + ", " + std::to_string(j) + ")", y_general[i], y_fused[i], 1e-13);
+  }
+}
+
+void test_mini_jacobian_dual(utest::error_accumulator &ea)
+{
+  constexpr size_t n = 4;
+  auto f = [](const auto *x, auto *y)
+  {
+    for (size_t i = 0; i < n; ++i)
+      y[i] = sin(x[(i + 1) % n]) - 0.3 * x[i] * x[(i + 2) % n];
+  };
+  auto jacobian_times = [](const double *x, const double *d, double *y)
+  {
+    for (size_t i = 0; i < n; ++i)
+      y[i] = std::cos(x[(i + 1) % n]) * d[(i + 1) % n] - 0.3 * (d[i] * x[(i + 2) % n] + x[i] * d[(i + 2) % n]);
+  };
+
+  const double x[n] = {0.3, -1.2, 0.7, 2.1};
+  const double h = 0.05;
+  rkgl::mini_jacobian<double> mj;
+  mj.set(n);
+  if (mj.evaluate_dual(f, x, h) != 2)
+    ea << "mini_jacobian::evaluate_dual returned a rank below 2";
+
+  // both directions are reproduced exactly: dx_0 = h f(x), dx_1 = h (J dx_0 - alpha dx_0)
+  double dx0[n], dx1[n], jd0[n], jd1[n], y[n];
+  f(x, dx0);
+  for (size_t i = 0; i < n; ++i)
+    dx0[i] *= h;
+  jacobian_times(x, dx0, jd0);
+  const double alpha = math::dot_product(n, dx0, jd0) / math::dot_product(n, dx0, dx0);
+  for (size_t i = 0; i < n; ++i)
+    dx1[i] = h * (jd0[i] - alpha * dx0[i]);
+  jacobian_times(x, dx1, jd1);
+
+  mj.aply(dx0, y);
+  for (size_t i = 0; i < n; ++i)
+    ea << utest::compare_numeric("wrong mini_jacobian dual J dx_0 (" + std::to_string(i) + ")", jd0[i], y[i], 1e-15);
+  mj.aply(dx1, y);
+  for (size_t i = 0; i < n; ++i)
+    ea << utest::compare_numeric("wrong mini_jacobian dual J dx_1 (" + std::to_string(i) + ")", jd1[i], y[i], 1e-15);
+}
@@ -0,0 +1,180 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <utest_frame.hpp>
+#include <utest_bench.hpp>
+#include <ling.hpp>
+#include <qode1.hpp>
+#include <rkgl.hpp>
+
+// ode_lab_ubench: timing regression checks of the hot kernels against a
+// baseline of this machine (ubench_baseline.txt in the build directory by
+// default; timings do not transfer between machines, so none is kept in
+// the source tree). Build in Release and run
+//
+//     ode_lab_ubench [--update] [--margin 0.25] [--baseline FILE]
+//
+// The first run, without a baseline file, records one. --update rewrites
+// it with the current medians. A kernel fails when its median exceeds
+// baseline * (1 + margin) + 3 MAD.
+
+#ifndef UBENCH_BASELINE
+#define UBENCH_BASELINE "ubench_baseline.txt"
+#endif
+
+template <size_t n>
+std::vector<double> diagonally_dominant()
+{
+  std::vector<double> A(n * n);
+  for (size_t i = 0; i < n * n; ++i)
+    A[i] = 0.1 * std::sin(0.7 * double(i));
+  for (size_t i = 0; i < n; ++i)
+    A[n * i + i] += 1.0;
+  return A;
+}
+
+template <size_t n>
+void bench_solve_opt(utest::error_accumulator &ea, utest::baseline &base)
+{
+  const std::vector<double> A0 = diagonally_dominant<n>();
+  double A[n * n], b[n];
+  const utest::timing t = utest::time_it([&]()
+                                         {
+                                           std::copy(A0.begin(), A0.end(), A);
+                                           std::fill(b, b + n, 1.0);
+                                           math::solve_opt<n>(A, b);
+                                           utest::do_not_optimize(b[0]); });
+  base.check(ea, "solve_opt<" + std::to_string(n) + ">", t);
+}
+
+void bench_linear_algebra(utest::error_accumulator &ea, utest::baseline &base)
+{
+  bench_solve_opt<2>(ea, base);
+  bench_solve_opt<4>(ea, base);
+  bench_solve_opt<6>(ea, base);
+
+  constexpr size_t n = 64;
+  const std::vector<double> A0 = diagonally_dominant<n>();
+  std::vector<double> A(n * n), v(n, 1.0);
+  base.check(ea, "lu_naive/64", utest::time_it([&]()
+                                               {
+                                                 std::copy(A0.begin(), A0.end(), A.begin());
+                                                 math::lu_naive(n, A.data());
+                                                 utest::do_not_optimize(A[0]); }));
+  base.check(ea, "fb_naive/64", utest::time_it([&]()
+                                               {
+                                                 math::fb_naive(n, A.data(), v.data());
+                                                 utest::do_not_optimize(v[0]); }));
+
+  std::vector<double> a(1024, 1.0), b(1024, 0.5);
+  base.check(ea, "dot_product/1024", utest::time_it([&]()
+                                                    { utest::do_not_optimize(math::dot_product(a.size(), a.data(), b.data())); }));
+}
+
+class Ring : public qode::qode1_core<double>
+{
+public:
+  explicit Ring(const size_t n) : qode::qode1_core<double>(n)
+  {
+    x.assign(n, 1.0);
+  }
+
+  void set_coef() override
+  {
+    const size_t n = dim();
+    for (size_t i = 0; i < n; ++i)
+    {
+      const size_t j = (i + 1) % n;
+      a_coef(i) = 0.1;
+      b_coef(i, i) = -0.5;
+      c_coef(i, i, j) = 0.05;
+      c_coef(i, j, j) = -0.02;
+    }
+  }
+};
+
+void bench_integrators(utest::error_accumulator &ea, utest::baseline &base)
+{
+  for (const size_t n : {4, 16})
+  {
+    Ring ring(n);
+    base.check(ea, "qode1_core::step/" + std::to_string(n), utest::time_it([&]()
+                                                                          {
+                                                                            ring.step(1e-3);
+                                                                            utest::do_not_optimize(ring.x[0]); }));
+  }
+
+  auto f = [](const double *x, double *y)
+  {
+    y[0] = 2.0 / 3.0 * x[0] - 4.0 / 3.0 * x[0] * x[1];
+    y[1] = x[0] * x[1] - x[1];
+  };
+  rkgl::mini_jacobian<double> mj;
+  mj.set(2);
+  rkgl::rkgl<double, 3> core;
+  core.set(2);
+  double x[2] = {1.0, 1.0};
+
+  base.check(ea, "mini_jacobian::evaluate/2", utest::time_it([&]()
+                                                            {
+                                                              mj.evaluate(f, x, 0.1);
+                                                              utest::do_not_optimize(mj); }));
+  base.check(ea, "rkgl<3>::step/2", utest::time_it([&]()
+                                                  {
+                                                    x[0] = x[1] = 1.0;
+                                                    mj.evaluate(f, x, 0.1);
+                                                    core.step(f, mj, x, 0.1, 1e-14);
+                                                    utest::do_not_optimize(x[0]); }));
+}
+
+int main(int argc, char **argv)
+{
+  std::string path = UBENCH_BASELINE;
+  utest::baseline base;
+  double margin = 0.25;
+  bool update = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--update")
+      update = true;
+    else if (arg == "--margin" && i + 1 < argc)
+      margin = std::stod(argv[++i]);
+    else if (arg == "--baseline" && i + 1 < argc)
+      path = argv[++i];
+    else
+    {
+      std::cerr << "usage: ode_lab_ubench [--update] [--margin 0.25] [--baseline FILE]\n";
+      return 2;
+    }
+  }
+
+  base = utest::baseline(path);
+  if (!base.loaded())
+  {
+    std::cout << "no baseline at " << path << ", recording one\n";
+    update = true;
+  }
+  base.margin = margin;
+  base.update = update;
+
+  utest::test_counter tc;
+
+  utest::write_category("linear algebra");
+  tc += utest::run([&](utest::error_accumulator &ea)
+                   { bench_linear_algebra(ea, base); }, "kernels");
+
+  utest::write_category("integrators");
+  tc += utest::run([&](utest::error_accumulator &ea)
+                   { bench_integrators(ea, base); }, "steps");
+
+  if (update)
+  {
+    base.save();
+    std::cout << "baseline written to " << path << "\n";
+  }
+
+  return tc.failed ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utest_frame.hpp>
+
+// =============================================================================
+//  FILE: utest_bench.hpp  -  micro-benchmarks with regression assertions
+// =============================================================================
+//
+//  utest::time_it(body) runs body() in samples of `iterations` calls after a
+//  few warm-up samples and returns the median and the median absolute
+//  deviation (MAD) of the time per call. With iterations == 0 the count is
+//  calibrated so that one sample takes about 2 ms.
+//
+//  utest::baseline holds reference medians "name median_ns" read from a text
+//  file. check(ea, name, t) reports a regression when
+//
+//      t.median > reference * (1 + margin) + 3 * t.mad,
+//
+//  i.e. only slowdowns larger than the margin and the measured noise fail.
+//  Entries without a reference pass with a note; with `update` set, check()
+//  records t.median instead and save() rewrites the file.
+//
+// =============================================================================
+
+namespace utest
+{
+  template <class T>
+  inline void do_not_optimize(T const &value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+  }
+
+  struct timing
+  {
+    double median_ns = 0.0;
+    double mad_ns = 0.0;
+    size_t iterations = 0;
+    int samples = 0;
+  };
+
+  inline double median(std::vector<double> v)
+  {
+    if (v.empty())
+      return 0.0;
+    const size_t m = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + m, v.end());
+    if (v.size() % 2 == 1)
+      return v[m];
+    const double upper = v[m];
+    return (*std::max_element(v.begin(), v.begin() + m) + upper) / 2;
+  }
+
+  inline double median_absolute_deviation(const std::vector<double> &v)
+  {
+    const double med = median(v);
+    std::vector<double> dev(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+      dev[i] = std::abs(v[i] - med);
+    return median(dev);
+  }
+
+  template <class F>
+  timing time_it(F &&body, size_t iterations = 0, const int samples = 15, const int warmup = 3)
+  {
+    using clock = std::chrono::steady_clock;
+
+    auto sample = [&](const size_t count)
+    {
+      const auto start = clock::now();
+      for (size_t i = 0; i < count; ++i)
+        body();
+      return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    };
+
+    if (iterations == 0)
+    {
+      iterations = 1;
+      while (sample(iterations) < 2e6 && iterations < (size_t(1) << 30))
+        iterations *= 2;
+    }
+
+    for (int i = 0; i < warmup; ++i)
+      sample(iterations);
+
+    std::vector<double> per_call(samples);
+    for (int i = 0; i < samples; ++i)
+      per_call[i] = sample(iterations) / double(iterations);
+
+    return {median(per_call), median_absolute_deviation(per_call), iterations, samples};
+  }
+
+  class baseline
+  {
+  public:
+    double margin = 0.25;
+    bool update = false;
+    bool verbose = true;
+
+    baseline() = default;
+    explicit baseline(const std::string &path) : file(path)
+    {
+      std::ifstream in(path);
+      found = bool(in);
+      std::string line;
+      while (std::getline(in, line))
+      {
+        if (line.empty() || line[0] == '#')
+          continue;
+        std::istringstream fields(line);
+        std::string name;
+        double ns;
+        if (fields >> name >> ns)
+          reference[name] = ns;
+      }
+    }
+
+    // true if the baseline file existed
+    bool loaded() const
+    {
+      return found;
+    }
+
+    void check(error_accumulator &ea, const std::string &name, const timing &t)
+    {
+      std::ostringstream line;
+      line << std::fixed << std::setprecision(2) << "  " << std::left << std::setw(32) << name << std::right
+           << std::setw(12) << t.median_ns << " ns  +- " << std::left << std::setw(8) << t.mad_ns << std::right;
+
+      const auto it = reference.find(name);
+      if (update)
+      {
+        reference[name] = t.median_ns;
+        report(line.str() + "  recorded");
+        return;
+      }
+      if (it == reference.end())
+      {
+        report(line.str() + "  no baseline");
+        return;
+      }
+
+      const double limit = it->second * (1 + margin) + 3 * t.mad_ns;
+      line << "  baseline " << std::setw(10) << it->second << " ns (" << std::showpos << std::setprecision(0)
+           << 100 * (t.median_ns / it->second - 1) << std::noshowpos << "%)";
+      report(line.str());
+
+      if (t.median_ns > limit)
+      {
+        std::ostringstream msg;
+        msg << std::fixed << std::setprecision(2) << name << " slowed down: " << t.median_ns
+            << " ns against a baseline of " << it->second << " ns (limit " << limit << " ns)";
+        ea << msg.str();
+      }
+    }
+
+    void save() const
+    {
+      std::ofstream out(file);
+      out << "# ode_lab_ubench baseline, machine specific: name median_ns (regenerate with --update)\n"
+          << std::fixed << std::setprecision(3);
+      for (const auto &[name, ns] : reference)
+        out << name << ' ' << ns << '\n';
+    }
+
+  private:
+    std::string file;
+    bool found = false;
+    std::map<std::string, double> reference;
+
+    void report(const std::string &line) const
+    {
+      if (verbose)
+        std::cout << line << '\n';
+    }
+  };
+
+  inline void test_timing_statistics(error_accumulator &ea)
+  {
+    ea << compare_numeric("wrong median (odd)", 3.0, median({5.0, 1.0, 3.0}));
+    ea << compare_numeric("wrong median (even)", 2.5, median({4.0, 1.0, 3.0, 2.0}));
+    ea << compare_numeric("wrong median absolute deviation", 1.0, median_absolute_deviation({1.0, 2.0, 3.0, 4.0, 100.0}));
+
+    size_t calls = 0;
+    const timing t = time_it([&]()
+                             { do_not_optimize(++calls); }, 10, 5, 2);
+    if (calls != 70 || t.iterations != 10 || !(t.median_ns >= 0.0))
+      ea << "time_it did not run the expected samples";
+
+    baseline b;
+    b.verbose = false;
+    b.update = true;
+    error_accumulator silent(true);
+    b.check(silent, "kernel", {100.0, 1.0, 1, 1});
+    b.update = false;
+    b.check(silent, "kernel", {120.0, 1.0, 1, 1});
+    try
+    {
+      silent.throw_if_any();
+    }
+    catch (const std::exception &)
+    {
+      ea << "baseline reported a slowdown within the margin";
+    }
+    b.check(silent, "kernel", {200.0, 1.0, 1, 1});
+    try
+    {
+      silent.throw_if_any();
+      ea << "baseline did not report a slowdown beyond the margin";
+    }
+    catch (const std::exception &)
+    {
+    }
+  }
+}
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <stdexcept>
 #include <utest_frame.hpp>
+#include <utest_bench.hpp>
 #include <ling_test.hpp>
+#include <qode_test.hpp>
+#include <precision_test.hpp>
+#include <rkgl_test.hpp>
 
 int main()
 {
@@ -10,6 +14,7 @@ int main()
   utest::write_category("smoke");
 
   tc += utest::run(utest::test_smoke, "utest");
+  tc += utest::run(utest::test_timing_statistics, "utest timing");
   if (tc.failed)
     return 1;
 
@@ -18,7 +23,54 @@ int main()
   tc += utest::run(test_dot_product, "dot_product");
   tc += utest::run(test_spectral_radius_estimate, "spectral_radius_estimate");
   tc += utest::run(test_solve_opt, "solve_opt");
+  tc += utest::run(test_lu_blocked, "lu_blocked");
   tc += utest::run(test_remove_tangent_components, "remove_tangent_components");
+  tc += utest::run(test_solve_refined, "solve_refined");
+  tc += utest::run(test_expm_pade, "expm_pade");
+  tc += utest::run(test_fb_multi, "fb_multi");
+  tc += utest::run(test_fb_transposed, "fb_transposed");
+  tc += utest::run(test_bisection_reverse, "bisection_reverse");
+  tc += utest::run(test_binomial_reverse, "binomial_reverse");
+  tc += utest::run(test_dual_jvp, "dual jvp");
+  tc += utest::run(test_solver_stats, "solver_stats");
+  tc += utest::run(test_thread_pool, "thread_pool");
+  tc += utest::run(test_parareal, "parareal");
+  tc += utest::run(test_kernel_config, "kernel_config");
+
+  utest::write_category("qode");
+
+  tc += utest::run(test_qode1_static, "qode1_static");
+  tc += utest::run(test_qode1_instance, "qode1_instance");
+  tc += utest::run(test_symmetric_kernel, "symmetric_kernel");
+  tc += utest::run(test_qode1_stats, "qode1_core stats");
+  tc += utest::run(test_qode1_mixed_precision, "qode1_mixed_precision");
+  tc += utest::run(test_qode1_imex, "qode1_imex");
+  tc += utest::run(test_qode1_file, "qode1_file");
+  tc += utest::run(test_trajectory, "trajectory");
+  tc += utest::run(test_steady_state, "steady_state");
+  tc += utest::run(test_composition, "composition");
+  tc += utest::run(test_richardson_controller, "richardson_controller");
+  tc += utest::run(test_verlet, "verlet");
+  tc += utest::run(test_ricatti, "ricatti_core");
+  tc += utest::run(test_lyapunov, "qode1_lyapunov");
+  tc += utest::run(test_qode1_sensitivity, "qode1_sensitivity");
+  tc += utest::run(test_qode1_adjoint, "qode1_adjoint");
+  tc += utest::run(test_controlled_integrators, "controlled integrators");
+
+  utest::write_category("rkgl");
+
+  tc += utest::run(test_gauss_legendre, "gauss_legendre");
+  tc += utest::run(test_rkgl_step, "rkgl::step");
+  tc += utest::run(test_rkgl_adjoint, "rkgl::adjoint_step");
+  tc += utest::run(test_rkgl_predictor, "rkgl predictor");
+  tc += utest::run(test_mini_jacobian_fused, "mini_jacobian fused evaluate");
+  tc += utest::run(test_mini_jacobian_dual, "mini_jacobian::evaluate_dual");
+
+  utest::write_category("precision");
+
+  tc += utest::run(test_precision_float, "float");
+  tc += utest::run(test_precision_long_double, "long double");
+  tc += utest::run(test_precision_double_double, "double_double");
 
   return tc.failed ? 1 : 0;
 }
\ No newline at end of file